@@ -0,0 +1,226 @@
+// Benchmark of the CPU sea stages over a sweep of grid sizes and thread counts:
+// the per-vertex wave_height() loop, the batch, phase table and strip height
+// evaluators, the sea normals, the caustic lightmap coordinates, the mesh
+// assembly and the whole CPU frame of the viewer's default path. Every stage
+// is timed repeats times after one warm-up run and reported as min, median and
+// 99th percentile, with ns per grid vertex and grid vertices per second at the
+// median. Only the simulation library is used, so it runs on any Linux box.
+//   ocean_bench [--grids 25,50,100] [--threads 1,2,4] [--repeats N] [--json out.json|-]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include "sea.h"
+#include "wave_table.h"
+#include "wave_strip.h"
+
+struct StageResult
+{
+    std::string stage;
+    int grid, vertices, threads;
+    double min_ms, median_ms, p99_ms;
+};
+
+
+static std::vector<int> parse_list(const char *s)
+{
+    std::vector<int> v;
+    for (const char *p = s; *p;)
+    {
+        char *end;
+        long n = strtol(p, &end, 10);
+        if (end == p)
+            break;
+        if (n > 0)
+            v.push_back((int)n);
+        p = *end == ',' ? end + 1 : end;
+    }
+    return v;
+}
+
+
+// sorted[i] for the smallest i with at least fraction q of the samples at or below it
+static double percentile(const std::vector<double> &sorted, double q)
+{
+    size_t i = (size_t)ceil(q * sorted.size());
+    return sorted[i > 0 ? i - 1 : 0];
+}
+
+
+static StageResult time_stage(const char *stage, const SeaGrid &g, int threads, int repeats,
+                              const std::function<void(float)> &f)
+{
+    std::vector<double> ms(repeats);
+    // the timer moves on every run like in the viewer, at 60 frames per second
+    f(0);
+    for (int r = 0; r < repeats; r++)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        f((r + 1) * 1000.0f / 60);
+        auto t1 = std::chrono::steady_clock::now();
+        ms[r] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    }
+    std::sort(ms.begin(), ms.end());
+    StageResult res;
+    res.stage = stage;
+    res.grid = g.xfield;
+    res.vertices = sea_vertices(g);
+    res.threads = threads;
+    res.min_ms = ms.front();
+    res.median_ms = percentile(ms, 0.5);
+    res.p99_ms = percentile(ms, 0.99);
+    return res;
+}
+
+
+static double ns_per_vertex(const StageResult &r) { return r.median_ms * 1e6 / r.vertices; }
+
+
+static void bench_grid(int field, int threads, int repeats, std::vector<StageResult> &results)
+{
+    SeaGrid g;
+    g.xfield = g.zfield = field;
+    WaveParams w;
+    JobSystem jobs(threads);
+    int n = sea_vertices(g);
+    std::vector<float> heights(n), normals(3 * n), causticUV(2 * n), seaUV(2 * n);
+    std::vector<float> causticMesh(5 * sea_mesh_vertices(g)), seaMesh(5 * sea_mesh_vertices(g));
+    // the planes of the viewer: caustics lightmap and environment map
+    const plane planes[2] = {plane(20, -1, 20, 20), plane(0, -1, 0, 12)};
+    float *const uvs[2] = {causticUV.data(), seaUV.data()};
+    WaveTable table;
+    wave_table_build(table, g, w, &jobs);
+
+    // one wave_height() call per vertex, as the sea was first built
+    results.push_back(time_stage("height_func", g, threads, repeats, [&](float t) {
+        parallel_for(&jobs, -g.xfield, g.xfield + 2, 1, [&](int x0, int x1) {
+            for (int xi = x0; xi < x1; xi++)
+                for (int zi = -g.zfield; zi <= g.zfield + 1; zi++)
+                    heights[sea_index(g, xi, zi)] = wave_height(w, xi, zi, t);
+        });
+    }));
+    results.push_back(time_stage("heights_batch", g, threads, repeats,
+                                 [&](float t) { sea_heights(g, w, t, heights.data(), &jobs); }));
+    results.push_back(time_stage("heights_table", g, threads, repeats,
+                                 [&](float t) { wave_table_heights(table, w, t, heights.data(), &jobs); }));
+    results.push_back(time_stage("heights_strip", g, threads, repeats,
+                                 [&](float t) { sea_heights_strip(g, w, t, heights.data(), &jobs); }));
+    results.push_back(time_stage("heights_normals", g, threads, repeats, [&](float t) {
+        sea_heights_normals(g, w, t, heights.data(), normals.data(), &jobs);
+    }));
+
+    wave_table_heights(table, w, 0, heights.data(), &jobs);
+    results.push_back(time_stage("normals", g, threads, repeats,
+                                 [&](float) { sea_normals(g, heights.data(), normals.data(), &jobs); }));
+    results.push_back(time_stage("caustic_uvs", g, threads, repeats, [&](float) {
+        sea_caustic_uvs_planes(g, heights.data(), normals.data(), planes, 2, uvs, &jobs);
+    }));
+    results.push_back(time_stage("mesh", g, threads, repeats, [&](float) {
+        sea_mesh(g, NULL, NULL, 0.01f, causticUV.data(), causticMesh.data(), &jobs);
+        sea_mesh(g, heights.data(), NULL, 0, seaUV.data(), seaMesh.data(), &jobs);
+    }));
+
+    // compute_height_field() of the viewer with the trig waves and light.png
+    results.push_back(time_stage("frame", g, threads, repeats, [&](float t) {
+        wave_table_heights(table, w, t, heights.data(), &jobs);
+        sea_normals(g, heights.data(), normals.data(), &jobs);
+        sea_caustic_uvs_planes(g, heights.data(), normals.data(), planes, 2, uvs, &jobs);
+        sea_mesh(g, NULL, NULL, 0.01f, causticUV.data(), causticMesh.data(), &jobs);
+        sea_mesh(g, heights.data(), NULL, 0, seaUV.data(), seaMesh.data(), &jobs);
+    }));
+}
+
+
+static void write_json(FILE *f, int repeats, const std::vector<StageResult> &results)
+{
+    fprintf(f, "{\n  \"benchmark\": \"ocean_bench\",\n  \"repeats\": %d,\n  \"hardware_threads\": %u,\n",
+            repeats, std::thread::hardware_concurrency());
+    fprintf(f, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const StageResult &r = results[i];
+        fprintf(f,
+                "    {\"stage\": \"%s\", \"grid\": %d, \"vertices\": %d, \"threads\": %d, "
+                "\"min_ms\": %.6f, \"median_ms\": %.6f, \"p99_ms\": %.6f, "
+                "\"ns_per_vertex\": %.4f, \"vertices_per_sec\": %.0f}%s\n",
+                r.stage.c_str(), r.grid, r.vertices, r.threads, r.min_ms, r.median_ms, r.p99_ms,
+                ns_per_vertex(r), 1e9 / ns_per_vertex(r), i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+
+static void print_usage(const char *name)
+{
+    printf("usage: %s [--grids 25,50,100] [--threads 1,2,4] [--repeats N] [--json out.json|-]\n", name);
+}
+
+
+int main(int argc, char **argv)
+{
+    int hw = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> grids = {25, 50, 100, 200};
+    std::vector<int> threads = {1};
+    if (hw > 1)
+        threads.push_back(hw);
+    int repeats = 50;
+    const char *json = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        bool more = i + 1 < argc;
+        if (!strcmp(argv[i], "--grids") && more)
+            grids = parse_list(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && more)
+            threads = parse_list(argv[++i]);
+        else if (!strcmp(argv[i], "--repeats") && more)
+            repeats = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--json") && more)
+            json = argv[++i];
+        else
+        {
+            print_usage(argv[0]);
+            return strcmp(argv[i], "--help") ? 1 : 0;
+        }
+    }
+    if (grids.empty() || threads.empty())
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<StageResult> results;
+    for (int field : grids)
+        for (int t : threads)
+            bench_grid(field, t, repeats, results);
+
+    // with the JSON on stdout the table would only get in the way
+    if (!json || strcmp(json, "-"))
+    {
+        printf("%d repeats per stage, grid = xfield = zfield\n", repeats);
+        printf("%-16s %5s %8s %7s %10s %10s %10s %9s %12s\n", "stage", "grid", "vertices", "threads", "min ms",
+               "median ms", "p99 ms", "ns/vert", "vert/s");
+        for (const StageResult &r : results)
+            printf("%-16s %5d %8d %7d %10.4f %10.4f %10.4f %9.2f %12.4g\n", r.stage.c_str(), r.grid, r.vertices,
+                   r.threads, r.min_ms, r.median_ms, r.p99_ms, ns_per_vertex(r), 1e9 / ns_per_vertex(r));
+    }
+    if (json)
+    {
+        FILE *f = strcmp(json, "-") ? fopen(json, "w") : stdout;
+        if (!f)
+        {
+            fprintf(stderr, "cannot write %s\n", json);
+            return 1;
+        }
+        write_json(f, repeats, results);
+        if (f != stdout)
+            fclose(f);
+    }
+    return 0;
+}
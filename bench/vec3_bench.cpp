@@ -0,0 +1,103 @@
+// Micro-benchmark of the legacy point class against vec3 on the two per-vertex
+// kernels that used point: the sea normal (cross product of the two forward
+// edges) and the caustic ray-plane intersection.
+//   vec3_bench [vertices] [repeats]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include "point.h"
+#include "vec3.h"
+
+static volatile float sink;
+
+
+template <typename F>
+static double best_ms(int repeats, F &&f)
+{
+    double best = 1e30;
+    for (int r = 0; r < repeats; r++)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        auto t1 = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        if (ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+
+int main(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 1 << 20;
+    int repeats = argc > 2 ? atoi(argv[2]) : 20;
+    std::vector<float> h(n + 2), nrm(3 * n), uv(2 * n);
+    for (int i = 0; i < n + 2; i++)
+        h[i] = 4.5f + 0.05f * (float)((i * 7919) % 1000) / 1000.0f;
+    const float q = 0.2f, pd = 20.0f;
+    const double pn[3] = {0.0, -1.0, 0.0};
+
+    // sea normal: e1 = (q, dh, 0), e2 = (0, dh', q), n = e1 ^ e2
+    double normal_point = best_ms(repeats, [&] {
+        for (int i = 0; i < n; i++)
+        {
+            point e1(q, h[i + 1] - h[i], 0);
+            point e2(0, h[i + 2] - h[i], q);
+            point e3 = e1 ^ e2;
+            nrm[3 * i] = e3.x;
+            nrm[3 * i + 1] = e3.y;
+            nrm[3 * i + 2] = e3.z;
+        }
+    });
+    sink = nrm[n / 2];
+    double normal_vec3 = best_ms(repeats, [&] {
+        for (int i = 0; i < n; i++)
+        {
+            vec3f e1(q, h[i + 1] - h[i], 0);
+            vec3f e2(0, h[i + 2] - h[i], q);
+            vec3_store(&nrm[3 * i], cross(e1, e2));
+        }
+    });
+    sink = nrm[n / 2];
+
+    // caustic ray: hit of p + t*normal with the plane n.x + d = 0
+    double ray_point = best_ms(repeats, [&] {
+        point pn_(pn[0], pn[1], pn[2]);
+        for (int i = 0; i < n; i++)
+        {
+            point p(i * q, h[i], -i * q);
+            point v(nrm[3 * i], nrm[3 * i + 1], nrm[3 * i + 2]);
+            point res = p;
+            double f = v * pn_;
+            if (f != 0)
+                res = p + v * (-(pn_ * p + pd) / f);
+            uv[2 * i] = res.x;
+            uv[2 * i + 1] = res.z;
+        }
+    });
+    sink = uv[n / 2];
+    double ray_vec3 = best_ms(repeats, [&] {
+        vec3f pn_(pn[0], pn[1], pn[2]);
+        for (int i = 0; i < n; i++)
+        {
+            vec3f p(i * q, h[i], -i * q);
+            vec3f v = vec3_load(&nrm[3 * i]);
+            vec3f res = p;
+            float f = dot(v, pn_);
+            if (f != 0)
+                res = p + v * (-(dot(pn_, p) + pd) / f);
+            uv[2 * i] = res.x;
+            uv[2 * i + 1] = res.z;
+        }
+    });
+    sink = uv[n / 2];
+
+    printf("%d vertices, best of %d\n", n, repeats);
+    printf("%-12s %10s %10s %8s\n", "kernel", "point ms", "vec3 ms", "speedup");
+    printf("%-12s %10.3f %10.3f %7.2fx\n", "sea normal", normal_point, normal_vec3, normal_point / normal_vec3);
+    printf("%-12s %10.3f %10.3f %7.2fx\n", "ray-plane", ray_point, ray_vec3, ray_point / ray_vec3);
+    return 0;
+}
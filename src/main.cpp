@@ -9,46 +9,83 @@
 
 #include "render/shader.h"
 #include "render/camera.h"
+#include "render/pass_timer.h"
 
-#include <ctime>
 #include <iostream>
+#include <fstream>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <cfloat>
+#include <getopt.h>
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
-#include "point.h"
-#include "plane.h"
+#include "sim/sea.h"
+#include "sim/fft_ocean.h"
+#include "sim/gerstner.h"
+#include "sim/wave_table.h"
+#include "sim/caustics.h"
+#include "sim/caustic_atlas.h"
+#include "sim/sim_clock.h"
+#include "sim/profiler.h"
 
 
-#define XFIELD 50
-#define ZFIELD 50
-
-#define QUADSIZE 0.4
-#define VTXSIZE (0.05f)
-#define TEXDIVIDER 40
-#define SPEED (0.008f)
-#define WAVESIZE (3.0f)
-
 float speed=250;
 
-int octaves=5;
 float elapsed;
-float timer;
-time_t start ,end;
-float func(float x,float z)
+float timer;    // ms, time of the frame being drawn
+
+// time source of the frames: the wall clock in the window, fixed steps offscreen so
+// every headless run shows the same sea states, or the frame times of a recorded run
+enum ClockMode { CLOCK_DEFAULT = 0, CLOCK_WALL, CLOCK_FIXED, CLOCK_REPLAY };
+int clockMode = CLOCK_DEFAULT;
+double clockStep = 1000.0 / 60;
+ReplayClock replayClock;
+const char *clockRecord = NULL;
+
+// simulation state shared by the sea passes
+SeaGrid grid;   // set through set_sea_grid()
+WaveParams wave;
+JobSystem *jobs = NULL;
+int jobThreads = 0;     // 0: one per hardware thread
+// planes hit by the sea normals: the caustics lightmap and the environment map
+plane causticPlane(20,-1,20,20);
+plane seaPlane(0,-1,0,12);
+// wave model building the heights: the trig sum of wave.h, the FFT ocean tile or Gerstner waves
+enum WaveModel { WAVES_TRIG = 0, WAVES_FFT, WAVES_GERSTNER };
+int waveModel = WAVES_TRIG;
+FftOceanParams oceanParams;
+std::unique_ptr<FftOcean> ocean;     // built on first use, rebuilt when the ImGui panel changes oceanParams
+GerstnerWaves gerstner = gerstner_wind_waves(32, 4.0f, 0.02f, 1.0f, 0.6f, 0.6f);
+// trig sum normals from the analytic gradient instead of the neighbouring heights
+bool analyticNormals = false;
+// evaluate the waves in waves.vs over a static grid instead of streaming cpu vertices;
+// waves.vs only knows the trig sum, so the other models always run on the cpu
+bool gpuWaves = false;
+bool gpu_waves() { return gpuWaves && waveModel == WAVES_TRIG; }
+// light on the seabed: the light.png lightmap mapped by the sea normals, photons traced
+// through the cpu sea, the sea grid refracted onto the seabed with area-ratio intensities,
+// or photon lightmaps replayed from a baked atlas. The traced modes need the cpu heights and
+// the atlas is laid on the cpu caustic mesh, so gpu waves fall back to light.png. So does
+// the atlas once the waves or the grid no longer match those it was baked for
+enum CausticsMode { CAUSTICS_LIGHTMAP = 0, CAUSTICS_PHOTONS, CAUSTICS_AREA, CAUSTICS_ATLAS };
+int causticsMode = CAUSTICS_LIGHTMAP;
+CausticParams causticParams;
+CausticMap causticMap;
+CausticRefraction causticRefraction;
+CausticAtlasReader causticAtlas;
+const char *causticAtlasPath = NULL;
+bool atlas_playable()
 {
-    float y=4.5;
-
-    float factor=1.0f;
-    float d=sqrt(x*x+z*z);
-    d=d/40.0f;
-    if (d>1.5) d=1.5f;
-    if (d<0) d=0;
-    for (int i=0;i<octaves;i++)
-    {
-        y-=	factor*VTXSIZE*d*cosf((timer*SPEED)+(1/factor)*x*z*WAVESIZE)+
-               (factor)*VTXSIZE*d*sinf((timer*SPEED)+(1/factor)*x*z*WAVESIZE) ;
-        factor=factor/2.0f;
-    }
-    return y;
+    return causticAtlas.is_open() && waveModel == WAVES_TRIG &&
+           caustic_atlas_matches(causticAtlas.header(),grid,wave);
+}
+int caustics_mode()
+{
+    if (gpu_waves() || (causticsMode == CAUSTICS_ATLAS && !atlas_playable()))
+        return CAUSTICS_LIGHTMAP;
+    return causticsMode;
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -57,8 +94,14 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
 unsigned int loadTexture(const char *path);
 void renderQuad();
-void computer_sea_caustics();
-void computer_sea();
+void set_sea_grid(const SeaGrid &g);
+void compute_height_field(float t);
+void computer_sea_caustics(Shader &shader);
+void computer_sea(Shader &shader);
+void save_framebuffer_ppm(const char *path, int width, int height);
+unsigned int upload_caustic_map();
+unsigned int stream_caustic_atlas(float t);
+unsigned int caustic_ramp();
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -74,12 +117,194 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// headless mode: render a fixed number of frames offscreen and report the frame times
+bool headless = false;
+int headlessFrames = 100;
+const char *headlessOutput = NULL;
+const char *headlessStats = NULL;
+// Chrome trace of the profiler scopes, written on exit or by the ImGui button
+const char *traceOutput = NULL;
+
+// performance panel: cpu and gpu time of every render pass, and the cpu time of the
+// sea stages feeding them, over the last frames
+enum RenderPass { PASS_SEABED = 0, PASS_CAUSTICS, PASS_SEA, PASS_SCREEN, PASS_COUNT };
+const char *passNames[PASS_COUNT] = {"seabed", "caustics", "sea", "screen"};
+PassTimer passTimers[PASS_COUNT];
+enum SeaStage { STAGE_WAVES = 0, STAGE_CAUSTICS, STAGE_MESH, STAGE_COUNT };
+const char *stageNames[STAGE_COUNT] = {"waves", "caustics", "sea mesh"};
+FrameStats stageStats[STAGE_COUNT];
+FrameStats frameStats;
+void performance_panel();
+
+void print_usage(const char *name)
+{
+    std::cout << "usage: " << name << " [--headless] [--frames N] [--output image.ppm] [--stats frames.csv]"
+              << " [--threads N] [--gpu-waves] [--waves trig|fft|gerstner] [--analytic-normals]"
+              << " [--caustics lightmap|photons|area] [--caustic-atlas file.ocat]"
+              << " [--clock wall|fixed] [--step ms] [--replay-clock times.txt] [--record-clock times.txt]"
+              << " [--grid field=50,quadsize=0.4,...] [--config grid.cfg] [--trace trace.json]" << std::endl;
+}
+
+void glfw_error_callback(int error, const char *description)
+{
+    std::cout << "GLFW error " << error << ": " << description << std::endl;
+}
+
 
-int main()
+int main(int argc, char **argv)
 {
+    // command line
+    // ------------
+    static const struct option options[] = {
+            {"headless", no_argument, NULL, 'H'},
+            {"frames", required_argument, NULL, 'n'},
+            {"output", required_argument, NULL, 'o'},
+            {"stats", required_argument, NULL, 's'},
+            {"threads", required_argument, NULL, 't'},
+            {"gpu-waves", no_argument, NULL, 'g'},
+            {"waves", required_argument, NULL, 'w'},
+            {"analytic-normals", no_argument, NULL, 'a'},
+            {"caustics", required_argument, NULL, 'c'},
+            {"caustic-atlas", required_argument, NULL, 'A'},
+            {"clock", required_argument, NULL, 'C'},
+            {"step", required_argument, NULL, 'S'},
+            {"replay-clock", required_argument, NULL, 'r'},
+            {"record-clock", required_argument, NULL, 'R'},
+            {"grid", required_argument, NULL, 'G'},
+            {"config", required_argument, NULL, 'F'},
+            {"trace", required_argument, NULL, 'T'},
+            {"help", no_argument, NULL, 'h'},
+            {NULL, 0, NULL, 0}
+    };
+    // later settings override earlier ones, the command line as well as config files
+    SeaGrid seaGrid;
+    int ch;
+    while ((ch = getopt_long(argc, argv, "Hn:o:s:t:gw:ac:A:C:S:r:R:G:F:T:h", options, NULL)) != -1)
+    {
+        switch (ch)
+        {
+            case 'H': headless = true; break;
+            case 'n': headlessFrames = std::max(1, atoi(optarg)); break;
+            case 'o': headlessOutput = optarg; break;
+            case 's': headlessStats = optarg; break;
+            case 't': jobThreads = atoi(optarg); break;
+            case 'g': gpuWaves = true; break;
+            case 'a': analyticNormals = true; break;
+            case 'c':
+                if (strcmp(optarg, "lightmap") == 0)
+                    causticsMode = CAUSTICS_LIGHTMAP;
+                else if (strcmp(optarg, "photons") == 0)
+                    causticsMode = CAUSTICS_PHOTONS;
+                else if (strcmp(optarg, "area") == 0)
+                    causticsMode = CAUSTICS_AREA;
+                else
+                {
+                    print_usage(argv[0]);
+                    return -1;
+                }
+                break;
+            case 'w':
+                if (strcmp(optarg, "trig") == 0)
+                    waveModel = WAVES_TRIG;
+                else if (strcmp(optarg, "fft") == 0)
+                    waveModel = WAVES_FFT;
+                else if (strcmp(optarg, "gerstner") == 0)
+                    waveModel = WAVES_GERSTNER;
+                else
+                {
+                    print_usage(argv[0]);
+                    return -1;
+                }
+                break;
+            case 'A':
+                // baked with caustic_bake; replayed instead of tracing the caustics, opened
+                // once the grid and waves are known
+                causticAtlasPath = optarg;
+                causticsMode = CAUSTICS_ATLAS;
+                break;
+            case 'C':
+                if (strcmp(optarg, "wall") == 0)
+                    clockMode = CLOCK_WALL;
+                else if (strcmp(optarg, "fixed") == 0)
+                    clockMode = CLOCK_FIXED;
+                else
+                {
+                    print_usage(argv[0]);
+                    return -1;
+                }
+                break;
+            case 'S':
+                clockStep = atof(optarg);
+                clockMode = CLOCK_FIXED;
+                break;
+            case 'r':
+                if (!replayClock.open(optarg))
+                {
+                    std::cout << "cannot read frame times " << optarg << std::endl;
+                    return -1;
+                }
+                clockMode = CLOCK_REPLAY;
+                break;
+            case 'R': clockRecord = optarg; break;
+            case 'G':
+                if (!sea_grid_parse(seaGrid, optarg))
+                {
+                    print_usage(argv[0]);
+                    return -1;
+                }
+                break;
+            case 'F':
+                if (!sea_grid_load(seaGrid, optarg))
+                {
+                    std::cout << "cannot read grid configuration " << optarg << std::endl;
+                    return -1;
+                }
+                break;
+            case 'T': traceOutput = optarg; break;
+            default: print_usage(argv[0]); return ch == 'h' ? 0 : -1;
+        }
+    }
+
+    if (!sea_grid_valid(seaGrid))
+    {
+        std::cout << "grid fields must be in [1, " << SEA_MAX_FIELD << "] and the sizes positive" << std::endl;
+        return -1;
+    }
+    set_sea_grid(seaGrid);
+    if (causticAtlasPath)
+    {
+        // the atlas holds caustics of the trig waves only
+        if (waveModel != WAVES_TRIG)
+        {
+            std::cout << "--caustic-atlas replays trig wave caustics and cannot run with --waves fft or gerstner"
+                      << std::endl;
+            return -1;
+        }
+        if (!causticAtlas.open(causticAtlasPath,grid,wave))
+        {
+            std::cout << "cannot read caustic atlas " << causticAtlasPath
+                      << ", or it was baked for another grid or other waves" << std::endl;
+            return -1;
+        }
+    }
+
+    // --trace records from the first frame; otherwise the ImGui checkbox starts it
+#ifdef OCEAN_PROFILE
+    profiler_thread_name("main");
+    profiler_enable(traceOutput != NULL);
+#else
+    if (traceOutput)
+        std::cout << "built without OCEAN_PROFILE, no trace will be written" << std::endl;
+#endif
+
+    // worker threads building the sea
+    jobs = new JobSystem(jobThreads);
+
     // glfw: initialize and configure
     // ------------------------------
-    glfwInit();
+    glfwSetErrorCallback(glfw_error_callback);
+    if (!glfwInit())
+        return -1;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -88,6 +313,14 @@ int main()
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
+    if (headless)
+    {
+        // offscreen OSMesa context; with OCEAN_HEADLESS glfw runs on its null platform
+        // and needs no display at all
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+    }
+
     // glfw window creation
     // --------------------
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "ocean base", NULL, NULL);
@@ -98,22 +331,24 @@ int main()
         return -1;
     }
     glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
+    if (!headless)
+    {
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetScrollCallback(window, scroll_callback);
 
-    // tell GLFW to capture our mouse
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        // tell GLFW to capture our mouse
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-    //imgui
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGuiIO &io = ImGui::GetIO();
-    // Setup Platform/Renderer bindings
-    ImGui_ImplGlfw_InitForOpenGL(window, true);
-    ImGui_ImplOpenGL3_Init();
-    // Setup Dear ImGui style
-    ImGui::StyleColorsDark();
+        //imgui
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        // Setup Platform/Renderer bindings
+        ImGui_ImplGlfw_InitForOpenGL(window, true);
+        ImGui_ImplOpenGL3_Init();
+        // Setup Dear ImGui style
+        ImGui::StyleColorsDark();
+    }
 
 
     // glad: load all OpenGL function pointers
@@ -127,6 +362,8 @@ int main()
     // configure global opengl state
     // -----------------------------
     glEnable(GL_DEPTH_TEST);
+    // offscreen contexts may start without a default framebuffer size
+    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
 
     // build and compile shaders
     // -------------------------
@@ -213,34 +450,106 @@ int main()
     // -------------
     glm::vec3 lightPos(0.0f, 3.0f, 0.0f);
 
+    // frame clock, started with the render loop
+    SimClock *simClock;
+    if (clockMode == CLOCK_REPLAY)
+        simClock = &replayClock;
+    else if (clockMode == CLOCK_FIXED || (clockMode == CLOCK_DEFAULT && headless))
+        simClock = new FixedStepClock(clockStep);
+    else
+        simClock = new WallClock();
+    RecordingClock recorder(simClock);
+    if (clockRecord && !recorder.open(clockRecord))
+    {
+        std::cout << "cannot write frame times " << clockRecord << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    SimClock *frameClock = clockRecord ? (SimClock *)&recorder : simClock;
+
     // render loop
-    start = clock();
+    std::vector<double> frameTimes;
     // -----------
-    while (!glfwWindowShouldClose(window))
+    while (!glfwWindowShouldClose(window) && (!headless || (int)frameTimes.size() < headlessFrames))
     {
-
-        //imgui
-        // feed inputs to dear imgui, start new frame
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-        // per-frame time logic
-        // --------------------
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-        std::string s = "Ocean base ";
-        s += std::to_string(1/deltaTime);
-        s += " fps  ";
-        glfwSetWindowTitle(window,(char *)s.c_str());
-        ImGui::Begin("Rendering Speed ");
-
-        ImGui::Text("%s", s.c_str());
-        ImGui::End();
-
-        // input
-        // -----
-        processInput(window);
+        OCEAN_PROFILE_SCOPE("frame");
+        double frameStart = glfwGetTime();
+        if (!headless)
+        {
+            OCEAN_PROFILE_SCOPE("imgui");
+            //imgui
+            // feed inputs to dear imgui, start new frame
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+            // per-frame time logic
+            // --------------------
+            float currentFrame = static_cast<float>(glfwGetTime());
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+            frameStats.add(deltaTime * 1000.0f);
+            std::string s = "Ocean base ";
+            s += std::to_string(1/deltaTime);
+            s += " fps  ";
+            glfwSetWindowTitle(window,(char *)s.c_str());
+            ImGui::Begin("Rendering Speed ");
+
+            ImGui::Text("%s", s.c_str());
+            ImGui::Checkbox("GPU waves", &gpuWaves);
+            ImGui::Combo("Waves", &waveModel, "trig sum\0FFT ocean\0Gerstner\0");
+            ImGui::Checkbox("Analytic normals", &analyticNormals);
+            ImGui::Combo("Caustics", &causticsMode, "light.png\0photons\0area ratio\0baked atlas\0");
+            if (waveModel == WAVES_FFT)
+            {
+                // any change redraws the spectrum on the next frame
+                int spectrum = oceanParams.spectrum;
+                if (ImGui::Combo("Spectrum", &spectrum, "Phillips\0JONSWAP\0"))
+                    oceanParams.spectrum = (OceanSpectrum)spectrum;
+                ImGui::SliderFloat("Wind speed", &oceanParams.windSpeed, 0.5f, 20.0f);
+                int seed = (int)oceanParams.seed;
+                if (ImGui::InputInt("Seed", &seed))
+                    oceanParams.seed = (unsigned int)seed;
+            }
+#ifdef OCEAN_PROFILE
+            // every recording starts from an empty trace
+            bool profiling = profiler_enabled();
+            if (ImGui::Checkbox("Profile", &profiling))
+            {
+                if (profiling)
+                    profiler_clear();
+                profiler_enable(profiling);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Write trace"))
+                profiler_write_trace(traceOutput ? traceOutput : "ocean_trace.json");
+            ImGui::SameLine();
+            if (ImGui::Button("Clear trace"))
+                profiler_clear();
+#endif
+            // edited on a copy and applied in one go, so a half typed size never rebuilds anything
+            ImGui::InputInt("X field", &seaGrid.xfield);
+            ImGui::InputInt("Z field", &seaGrid.zfield);
+            ImGui::InputFloat("Quad size", &seaGrid.quadsize);
+            ImGui::InputFloat("Tex divider", &seaGrid.texdivider);
+            if (ImGui::Button("Apply grid"))
+            {
+                seaGrid.xfield = std::min(std::max(seaGrid.xfield, 1), SEA_MAX_FIELD);
+                seaGrid.zfield = std::min(std::max(seaGrid.zfield, 1), SEA_MAX_FIELD);
+                if (sea_grid_valid(seaGrid))
+                    set_sea_grid(seaGrid);
+                else
+                    seaGrid = grid;
+            }
+            ImGui::End();
+            performance_panel();
+        }
+        if (!headless)
+        {
+            // input
+            // -----
+            OCEAN_PROFILE_SCOPE("input");
+            processInput(window);
+        }
 
         // render
         // -----------------------------------------------------------------------------------------------
@@ -274,7 +583,16 @@ int main()
         glBindTexture(GL_TEXTURE_2D, normalMap);
         glActiveTexture(GL_TEXTURE2);
         glBindTexture(GL_TEXTURE_2D, heightMap);
-        renderQuad();
+        {
+            OCEAN_PROFILE_SCOPE("floor pass");
+            passTimers[PASS_SEABED].begin();
+            renderQuad();
+            passTimers[PASS_SEABED].end();
+        }
+
+        // evaluate the waves once for this frame; both sea passes read the cached grid
+        timer = (float)frameClock->next_frame();
+        compute_height_field(timer);
 
         //second render pass: render caustics of light
         cauticsShader.use();
@@ -282,8 +600,17 @@ int main()
         cauticsShader.setMat4("view", view);
         cauticsShader.setMat4("model", model);
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, causticsMap);
-        computer_sea_caustics();
+        passTimers[PASS_CAUSTICS].begin();
+        if (caustics_mode() == CAUSTICS_PHOTONS)
+            glBindTexture(GL_TEXTURE_2D, upload_caustic_map());
+        else if (caustics_mode() == CAUSTICS_AREA)
+            glBindTexture(GL_TEXTURE_2D, caustic_ramp());
+        else if (caustics_mode() == CAUSTICS_ATLAS)
+            glBindTexture(GL_TEXTURE_2D, stream_caustic_atlas(timer));
+        else
+            glBindTexture(GL_TEXTURE_2D, causticsMap);
+        computer_sea_caustics(cauticsShader);
+        passTimers[PASS_CAUSTICS].end();
 
 
         //third render pass: render over waves
@@ -293,7 +620,22 @@ int main()
         seaShader.setMat4("model", model);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, enviorMap);
-        computer_sea();
+        passTimers[PASS_SEA].begin();
+        computer_sea(seaShader);
+        passTimers[PASS_SEA].end();
+
+        if (headless)
+        {
+            // the frame ends in the offscreen framebuffer; wait for the GL so the timing covers the whole frame
+            {
+                OCEAN_PROFILE_SCOPE("gl finish");
+                glFinish();
+            }
+            frameTimes.push_back((glfwGetTime() - frameStart) * 1000.0);
+            if ((int)frameTimes.size() == headlessFrames && headlessOutput)
+                save_framebuffer_ppm(headlessOutput, SCR_WIDTH, SCR_HEIGHT);
+            continue;
+        }
 
         // now bind back to default framebuffer and draw a quad plane with the attached framebuffer color texture
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -302,104 +644,444 @@ int main()
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f); // set clear color to white (not really necessary actually, since we won't be able to see behind the quad anyways)
         glClear(GL_COLOR_BUFFER_BIT);
 
-        screenShader.use();
-        glBindVertexArray(quadVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, textureColorbuffer);	// use the color attachment texture as the texture of the quad plane
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        {
+            OCEAN_PROFILE_SCOPE("screen pass");
+            passTimers[PASS_SCREEN].begin();
+            screenShader.use();
+            glBindVertexArray(quadVAO);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, textureColorbuffer);	// use the color attachment texture as the texture of the quad plane
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+            passTimers[PASS_SCREEN].end();
+        }
 
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            OCEAN_PROFILE_SCOPE("imgui render");
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            OCEAN_PROFILE_SCOPE("swap");
+            glfwSwapBuffers(window);
+        }
+        {
+            OCEAN_PROFILE_SCOPE("input");
+            glfwPollEvents();
+        }
+    }
+
+    if (headless && !frameTimes.empty())
+    {
+        // per-frame throughput of the offscreen run
+        std::vector<double> sorted(frameTimes);
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0;
+        for (double t : frameTimes) total += t;
+        double mean = total / frameTimes.size();
+        std::cout << "headless: " << frameTimes.size() << " frames " << SCR_WIDTH << "x" << SCR_HEIGHT
+                  << ", mean " << mean << " ms (" << 1000.0 / mean << " fps)"
+                  << ", min " << sorted.front() << " ms"
+                  << ", median " << sorted[sorted.size() / 2] << " ms"
+                  << ", max " << sorted.back() << " ms" << std::endl;
+        // the last frames' queries have finished with the glFinish of their frame
+        for (int i = 0; i < PASS_COUNT; i++)
+        {
+            PassTimer &pt = passTimers[i];
+            pt.collect();
+            if (pt.cpu.count == 0)
+                continue;
+            std::cout << "pass " << passNames[i] << ": gpu p50 " << pt.gpu.percentile(0.5f)
+                      << " p95 " << pt.gpu.percentile(0.95f) << " p99 " << pt.gpu.percentile(0.99f)
+                      << " ms (" << pt.gpu.count << " queries, " << pt.dropped << " dropped)"
+                      << ", cpu p50 " << pt.cpu.percentile(0.5f) << " ms" << std::endl;
+        }
+        if (headlessStats)
+        {
+            std::ofstream stats(headlessStats);
+            stats << "frame,ms" << std::endl;
+            for (size_t i = 0; i < frameTimes.size(); i++)
+                stats << i << "," << frameTimes[i] << std::endl;
+        }
     }
 
+#ifdef OCEAN_PROFILE
+    if (traceOutput && !profiler_write_trace(traceOutput))
+        std::cout << "cannot write trace " << traceOutput << std::endl;
+#endif
+
     glfwTerminate();
+    recorder.close();
+    if (simClock != &replayClock)
+        delete simClock;
+    delete jobs;
     return 0;
 }
-unsigned int SeaVAO = 0;
-unsigned int SeaVBO;
+// height field cache: height, sea normal and lightmap coordinates of every grid vertex,
+// filled once per frame so the wave model runs once per vertex for both passes
+// ---------------------------------------------------------------------------------
+std::vector<float> hfHeight;
+std::vector<float> hfNormal;
+std::vector<float> hfCausticUV;
+std::vector<float> hfSeaUV;
+std::vector<float> hfDisp;      // horizontal displacement of the Gerstner waves
+
+// grid mesh vertices of both passes, built in parallel and uploaded in one piece per pass
+std::vector<float> causticMesh;
+std::vector<float> seaMesh;
+// causticMesh holds the fixed mesh of the atlas, and the caustic vertex buffer holds it too
+bool atlasMeshBuilt = false;
+bool atlasMeshUploaded = false;
+
+// heights and sea normals of the wave model at time t
+void compute_waves(float t)
+{
+    OCEAN_PROFILE_SCOPE("waves");
+    // t counts milliseconds, the FFT ocean and Gerstner waves run in seconds
+    if (waveModel == WAVES_GERSTNER)
+    {
+        // analytic normals and the trochoidal displacement come with the heights
+        gerstner_sea(grid,gerstner,t / 1000.0f,wave.level,hfHeight.data(),hfNormal.data(),hfDisp.data(),jobs);
+    }
+    else if (waveModel == WAVES_TRIG && analyticNormals)
+        sea_heights_normals(grid,wave,t,hfHeight.data(),hfNormal.data(),jobs);
+    else
+    {
+        if (waveModel == WAVES_FFT)
+        {
+            static std::vector<float> tile;
+            if (!ocean || !fft_ocean_matches(*ocean,oceanParams))
+                ocean = std::make_unique<FftOcean>(oceanParams);
+            tile.resize(ocean->size() * ocean->size());
+            ocean->evaluate(t / 1000.0f, tile.data(), NULL, NULL, NULL, NULL, jobs);
+            fft_ocean_sea_heights(grid,oceanParams,tile.data(),wave.level,hfHeight.data(),jobs);
+        }
+        else
+        {
+            // the spatial phases only change with the grid or the wave shape
+            static WaveTable table;
+            if (!wave_table_matches(table,grid,wave))
+                wave_table_build(table,grid,wave,jobs);
+            wave_table_heights(table,wave,t,hfHeight.data(),jobs);
+        }
+        sea_normals(grid,hfHeight.data(),hfNormal.data(),jobs);
+    }
+}
 
-void computer_sea_caustics(){
-   end = clock();
-    timer=(float)(end - start)/CLOCKS_PER_SEC * 1000.0f;
-// second pass: caustic on top of the floor as an additive blend
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE, GL_ONE);
-    glDepthMask(GL_FALSE);
-    glDepthFunc(GL_LEQUAL);
-  if(SeaVAO == 0){
-      glGenVertexArrays(1, &SeaVAO);
-      glGenBuffers(1, &SeaVBO);
-  }
+// lightmap coordinates of both passes, and the traced caustics
+void compute_caustics()
+{
+    OCEAN_PROFILE_SCOPE("caustics");
+    if (caustics_mode() == CAUSTICS_PHOTONS)
+    {
+        // the caustic mesh samples the traced lightmap right under each vertex
+        caustics_photons(grid,hfHeight.data(),hfNormal.data(),causticParams,causticMap,jobs);
+        sea_floor_uvs(grid,hfCausticUV.data(),jobs);
+        sea_caustic_uvs(grid,hfHeight.data(),hfNormal.data(),seaPlane,hfSeaUV.data(),jobs);
+    }
+    else if (caustics_mode() == CAUSTICS_ATLAS || caustics_mode() == CAUSTICS_AREA)
+    {
+        // their caustic meshes carry no lightmap coordinates of the normals, see compute_meshes()
+        sea_caustic_uvs(grid,hfHeight.data(),hfNormal.data(),seaPlane,hfSeaUV.data(),jobs);
+    }
+    else
+    {
+        // both lightmaps in one pass over the normals
+        const plane planes[2] = {causticPlane,seaPlane};
+        float *const uvs[2] = {hfCausticUV.data(),hfSeaUV.data()};
+        sea_caustic_uvs_planes(grid,hfHeight.data(),hfNormal.data(),planes,2,uvs,jobs);
+    }
+}
 
-    for (int xi=-XFIELD;xi<XFIELD;xi++)
+// the caustic mesh is laid on the floor, the sea mesh follows the wave heights
+void compute_meshes()
+{
+    OCEAN_PROFILE_SCOPE("sea mesh");
+    bool atlas = caustics_mode() == CAUSTICS_ATLAS;
+    if (atlas && !atlasMeshBuilt)
     {
-        int size_of_vertex = 0;
-        std::vector<float> vertexBuffer;
-        for (int zi=-XFIELD;zi<ZFIELD;zi++)
-        {
-            // compute caustic environment mapping for point 1 in the strip
-            point p(xi*QUADSIZE,0,zi*QUADSIZE);p.y=func(xi,zi);
-            point q((xi+1)*QUADSIZE,0,zi*QUADSIZE);q.y=func(xi+1,zi);
-            point r((xi)*QUADSIZE,0,(zi+1)*QUADSIZE);r.y=func(xi,zi+1);
-
-            point e1=q-p;
-            point e2=r-p;
-            point e3=e1^e2;	// e3 is the normal of the sea above the sampling point #1
-
-
-            plane pl(20,-1,20,20);
-            point res;
-            pl.testline(p,e3,res);
-            // compute the collision to the lightmap
-            vertexBuffer.push_back(p.x);
-            vertexBuffer.push_back(0.01f);
-            vertexBuffer.push_back(p.z);
-            vertexBuffer.push_back(res.x/TEXDIVIDER);
-            vertexBuffer.push_back(res.z/TEXDIVIDER);
-            size_of_vertex ++;
-
-            // compute caustic environment mapping for point 2 in the strip (shift 1 in xi)
-            p=q;
-            q.create((xi+2)*QUADSIZE,0,zi*QUADSIZE);q.y=func(xi+2,zi);
-            r.create((xi+1)*QUADSIZE,0,(zi+1)*QUADSIZE);r.y=func(xi+1,zi+1);
-
-            e1=q-p;
-            e2=r-p;
-            e3=e1^e2;
-            // e3 is the normal of the sea above the sampling point #2
-
-            pl.testline(p,e3,res);
-            // compute the collision to the lightmap
-            vertexBuffer.push_back(p.x);
-            vertexBuffer.push_back(0.01f);
-            vertexBuffer.push_back(p.z);
-            vertexBuffer.push_back(res.x/TEXDIVIDER);
-            vertexBuffer.push_back(res.z/TEXDIVIDER);
-            size_of_vertex ++;
+        // baked lightmaps cover the seabed like the traced ones, each vertex sampling the
+        // texel right under it; the mesh never moves, so it is only built again for a new grid
+        sea_floor_uvs(grid,hfCausticUV.data(),jobs);
+        sea_mesh(grid,NULL,NULL,0.01f,hfCausticUV.data(),causticMesh.data(),jobs);
+        atlasMeshUploaded = false;
+    }
+    else if (caustics_mode() == CAUSTICS_AREA)
+    {
+        // the sea grid refracted onto the floor, its intensities in u
+        caustics_refract(grid,hfHeight.data(),hfNormal.data(),causticParams,causticRefraction,jobs);
+        caustics_area_mesh(grid,causticRefraction,causticParams,0.01f,causticMesh.data(),jobs);
+    }
+    else if (!atlas)
+        sea_mesh(grid,NULL,NULL,0.01f,hfCausticUV.data(),causticMesh.data(),jobs);
+    atlasMeshBuilt = atlas;
+    // only Gerstner waves move the vertices sideways
+    const float *disp = waveModel == WAVES_GERSTNER ? hfDisp.data() : NULL;
+    sea_mesh(grid,hfHeight.data(),disp,0,hfSeaUV.data(),seaMesh.data(),jobs);
+}
 
-        }
-        glBindVertexArray(SeaVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, SeaVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 5 * size_of_vertex, (vertexBuffer.data()), GL_STATIC_DRAW);
+void compute_height_field(float t)
+{
+    if (gpu_waves())
+        return;
+    double t0 = glfwGetTime();
+    compute_waves(t);
+    double t1 = glfwGetTime();
+    compute_caustics();
+    double t2 = glfwGetTime();
+    compute_meshes();
+    double t3 = glfwGetTime();
+    stageStats[STAGE_WAVES].add((float)((t1 - t0) * 1000.0));
+    stageStats[STAGE_CAUSTICS].add((float)((t2 - t1) * 1000.0));
+    stageStats[STAGE_MESH].add((float)((t3 - t2) * 1000.0));
+}
 
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
+// one line of percentiles and a graph of the recent frames
+void stats_row(const char *label, const FrameStats &st)
+{
+    ImGui::Text("%-9s p50 %6.3f  p95 %6.3f  p99 %6.3f ms", label, st.percentile(0.5f), st.percentile(0.95f),
+                st.percentile(0.99f));
+    ImGui::PushID(label);
+    ImGui::PlotLines("##graph", st.samples, st.count, st.oldest(), NULL, 0.0f, FLT_MAX, ImVec2(0, 30));
+    ImGui::PopID();
+}
 
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
+void performance_panel()
+{
+    ImGui::Begin("Performance");
+    stats_row("frame", frameStats);
+    ImGui::Separator();
+    ImGui::Text("GPU passes");
+    for (int i = 0; i < PASS_COUNT; i++)
+        stats_row(passNames[i], passTimers[i].gpu);
+    ImGui::Separator();
+    ImGui::Text("CPU passes");
+    for (int i = 0; i < PASS_COUNT; i++)
+        stats_row(passNames[i], passTimers[i].cpu);
+    ImGui::Separator();
+    ImGui::Text("CPU sea stages");
+    for (int i = 0; i < STAGE_COUNT; i++)
+        stats_row(stageNames[i], stageStats[i]);
+    ImGui::End();
+}
+
+// sea meshes: each pass owns a vertex buffer for the whole grid, allocated once and
+// refilled every frame, and both draw it with one static index buffer
+// ----------------------------------------------------------------------------------
+unsigned int seaEBO = 0;
+int seaIndexCount = 0;
+
+// binds the shared index buffer to the current vertex array, creating it on first use
+void bind_sea_indices()
+{
+    if (seaEBO == 0)
+    {
+        seaIndexCount = sea_mesh_index_count(grid);
+        std::vector<unsigned int> indices(seaIndexCount);
+        sea_mesh_indices(grid, indices.data());
+        glGenBuffers(1, &seaEBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, seaEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * seaIndexCount, indices.data(), GL_STATIC_DRAW);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, seaEBO);
+}
+
+void create_sea_mesh(unsigned int &vao, unsigned int &vbo)
+{
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 5 * sea_mesh_vertices(grid), NULL, GL_STREAM_DRAW);
+
+    bind_sea_indices();
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
 
-        //draw:
-        glBindVertexArray(SeaVAO);
-        glDrawArrays(GL_TRIANGLE_STRIP,0,size_of_vertex);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+}
+
+// draws the mesh after uploading vertices, or what vbo holds when vertices is NULL
+void draw_sea_mesh(unsigned int vao, unsigned int vbo, const float *vertices)
+{
+    // orphan last frame's storage so the upload never waits for draws still reading it
+    GLsizeiptr size = sizeof(float) * 5 * sea_mesh_vertices(grid);
+    if (vertices)
+    {
+        OCEAN_PROFILE_SCOPE("mesh upload");
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size, vertices);
+    }
+
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, seaIndexCount, GL_UNSIGNED_INT, (void*)0);
+    glBindVertexArray(0);
+}
+
+// gpu waves: a static mesh of grid coordinates (xi,0,zi), uploaded once; waves.vs
+// displaces it and computes the sea normal and lightmap coordinates itself
+// ---------------------------------------------------------------------------------
+unsigned int gridVAO = 0;
+unsigned int gridVBO;
+
+void draw_gpu_waves(Shader &shader, plane &pl, bool flatten, float floorY)
+{
+    if (gridVAO == 0)
+    {
+        std::vector<float> vertices;
+        for (int xi = -grid.xfield; xi <= grid.xfield; xi++)
+            for (int zi = -grid.zfield; zi < grid.zfield; zi++)
+            {
+                vertices.push_back(xi);
+                vertices.push_back(0);
+                vertices.push_back(zi);
+            }
+        glGenVertexArrays(1, &gridVAO);
+        glGenBuffers(1, &gridVBO);
+        glBindVertexArray(gridVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, gridVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+        bind_sea_indices();
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
         glBindVertexArray(0);
     }
+    shader.setFloat("timer", timer);
+    shader.setInt("octaves", wave.octaves);
+    shader.setFloat("speed", wave.speed);
+    shader.setFloat("wavesize", wave.wavesize);
+    shader.setFloat("vtxsize", wave.vtxsize);
+    shader.setFloat("level", wave.level);
+    shader.setFloat("quadsize", grid.quadsize);
+    shader.setFloat("texdivider", grid.texdivider);
+    shader.setVec4("lightPlane", pl.n.x, pl.n.y, pl.n.z, pl.d);
+    shader.setBool("flatten", flatten);
+    shader.setFloat("floorY", floorY);
+
+    glBindVertexArray(gridVAO);
+    glDrawElements(GL_TRIANGLES, seaIndexCount, GL_UNSIGNED_INT, (void*)0);
+    glBindVertexArray(0);
+}
 
+// photon caustics lightmap: one channel, replicated to rgb by the texture swizzle,
+// created on first use and refilled every frame, or by a baked atlas frame
+unsigned int causticTexture = 0;
+int causticTextureSize = 0;
+int causticAtlasFrame = -1;     // atlas frame held by causticTexture, -1 when it holds something else
 
+unsigned int upload_caustic_bytes(const unsigned char *bytes, int size)
+{
+    OCEAN_PROFILE_SCOPE("caustic upload");
+    if (causticTexture == 0)
+    {
+        glGenTextures(1, &causticTexture);
+        glBindTexture(GL_TEXTURE_2D, causticTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        GLint swizzle[4] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+    glBindTexture(GL_TEXTURE_2D, causticTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (size != causticTextureSize)
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, size, size, 0, GL_RED, GL_UNSIGNED_BYTE, bytes);
+        causticTextureSize = size;
+    }
+    else
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RED, GL_UNSIGNED_BYTE, bytes);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    return causticTexture;
+}
+
+unsigned int upload_caustic_map()
+{
+    static std::vector<unsigned char> bytes;
+    int size = causticMap.size;
+    bytes.resize(size * size);
+    caustic_map_bytes(causticMap,causticParams,bytes.data(),jobs);
+    causticAtlasFrame = -1;
+    return upload_caustic_bytes(bytes.data(), size);
+}
+
+// baked caustics: the frame of the atlas for time t is read from the file and
+// uploaded only when it changes, so playback costs one frame read now and then
+unsigned int stream_caustic_atlas(float t)
+{
+    static std::vector<unsigned char> bytes;
+    int frame = causticAtlas.frame_at(t);
+    if (frame == causticAtlasFrame)
+        return causticTexture;
+    int size = causticAtlas.header().size;
+    bytes.resize(size * size);
+    if (!causticAtlas.read_frame(frame, bytes.data()))
+        return causticTexture;
+    causticAtlasFrame = frame;
+    return upload_caustic_bytes(bytes.data(), size);
+}
+
+// area-ratio caustics: a grey ramp whose brightness along u is u itself, so the caustics
+// pass turns the intensity the mesh carries in u into light
+unsigned int caustic_ramp()
+{
+    static unsigned int ramp = 0;
+    if (ramp == 0)
+    {
+        unsigned char bytes[256];
+        for (int i = 0; i < 256; i++)
+            bytes[i] = (unsigned char)i;
+        glGenTextures(1, &ramp);
+        glBindTexture(GL_TEXTURE_2D, ramp);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        GLint swizzle[4] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, 256, 1, 0, GL_RED, GL_UNSIGNED_BYTE, bytes);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    return ramp;
+}
+
+unsigned int SeaVAO = 0;
+unsigned int SeaVBO;
+
+void computer_sea_caustics(Shader &shader){
+// second pass: caustic on top of the floor as an additive blend
+    OCEAN_PROFILE_SCOPE("caustics pass");
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glDepthMask(GL_FALSE);
+    glDepthFunc(GL_LEQUAL);
+    shader.setBool("gpuWaves", gpu_waves());
+    if (gpu_waves())
+    {
+        draw_gpu_waves(shader, causticPlane, true, 0.01f);
+        return;
+    }
+    if (SeaVAO == 0)
+    {
+        create_sea_mesh(SeaVAO, SeaVBO);
+        atlasMeshUploaded = false;
+    }
+    // the atlas mesh stays in the buffer from one frame to the next
+    if (caustics_mode() == CAUSTICS_ATLAS)
+    {
+        draw_sea_mesh(SeaVAO, SeaVBO, atlasMeshUploaded ? NULL : causticMesh.data());
+        atlasMeshUploaded = true;
+    }
+    else
+        draw_sea_mesh(SeaVAO, SeaVBO, causticMesh.data());
 }
 
 // renders a 1x1 quad in NDC with manually calculated tangent vectors
@@ -496,79 +1178,53 @@ void renderQuad()
 unsigned int waveVAO = 0;
 unsigned int waveVBO;
 
-void computer_sea() {
+void computer_sea(Shader &shader) {
+    OCEAN_PROFILE_SCOPE("sea pass");
     glDepthMask(GL_TRUE);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
-    if (waveVAO == 0) {
-        glGenVertexArrays(1, &waveVAO);
-        glGenBuffers(1, &waveVBO);
-    }
-
-    for (int xi =-XFIELD; xi < XFIELD; xi++) {
-        int size_of_vertex = 0;
-        std::vector<float> vertexBuffer;
-        for (int zi = -XFIELD; zi < ZFIELD; zi++) {
-            // compute caustic environment mapping for point 1 in the strip
-            point p(xi * QUADSIZE, 0, zi * QUADSIZE);
-            p.y = func(xi, zi);
-            point q((xi + 1) * QUADSIZE, 0, zi * QUADSIZE);
-            q.y = func(xi + 1, zi);
-            point r((xi) * QUADSIZE, 0, (zi + 1) * QUADSIZE);
-            r.y = func(xi, zi + 1);
-
-            point e1 = q - p;
-            point e2 = r - p;
-            point e3 = e1 ^ e2;    // e3 is the normal of the sea above the sampling point #1
-
-
-            plane pl(0, -1, 0, 12);
-            point res;
-            pl.testline(p, e3, res);
-            // compute the collision to the lightmap
-            vertexBuffer.push_back(p.x);
-            vertexBuffer.push_back(p.y);
-            vertexBuffer.push_back(p.z);
-            vertexBuffer.push_back(res.x / TEXDIVIDER);
-            vertexBuffer.push_back(res.z / TEXDIVIDER);
-            size_of_vertex++;
-
-            // compute caustic environment mapping for point 2 in the strip (shift 1 in xi)
-            p = q;
-            q.create((xi + 2) * QUADSIZE, 0, zi * QUADSIZE);
-            q.y = func(xi + 2, zi);
-            r.create((xi + 1) * QUADSIZE, 0, (zi + 1) * QUADSIZE);
-            r.y = func(xi + 1, zi + 1);
-
-            e1 = q - p;
-            e2 = r - p;
-            e3 = e1 ^ e2;
-            // e3 is the normal of the sea above the sampling point #2
-
-            pl.testline(p, e3, res);
-            // compute the collision to the lightmap
-            vertexBuffer.push_back(p.x);
-            vertexBuffer.push_back(p.y);
-            vertexBuffer.push_back(p.z);
-            vertexBuffer.push_back(res.x / TEXDIVIDER);
-            vertexBuffer.push_back(res.z / TEXDIVIDER);
-            size_of_vertex++;
+    shader.setBool("gpuWaves", gpu_waves());
+    if (gpu_waves()) {
+        draw_gpu_waves(shader, seaPlane, false, 0);
+        return;
+    }
+    if (waveVAO == 0)
+        create_sea_mesh(waveVAO, waveVBO);
+    draw_sea_mesh(waveVAO, waveVBO, seaMesh.data());
+}
 
+// switches the sea to grid g. The cpu buffers follow the vertex count; the index buffer,
+// the vertex arrays using it and the gpu waves grid only depend on the extent and are
+// dropped, to be recreated on their next draw, only when the extent changes. The spacing
+// and the lightmap repeat are read every frame and need no rebuild at all
+void set_sea_grid(const SeaGrid &g)
+{
+    bool extent = g.xfield != grid.xfield || g.zfield != grid.zfield || hfHeight.empty();
+    grid = g;
+    atlasMeshBuilt = false;
+    if (!extent)
+        return;
+    size_t n = sea_vertices(grid);
+    hfHeight.resize(n);
+    hfNormal.resize(3 * n);
+    hfCausticUV.resize(2 * n);
+    hfSeaUV.resize(2 * n);
+    hfDisp.resize(2 * n);
+    causticMesh.resize(5 * (size_t)sea_mesh_vertices(grid));
+    seaMesh.resize(5 * (size_t)sea_mesh_vertices(grid));
+    unsigned int *vaos[3] = {&SeaVAO, &waveVAO, &gridVAO};
+    unsigned int *vbos[3] = {&SeaVBO, &waveVBO, &gridVBO};
+    for (int i = 0; i < 3; i++)
+        if (*vaos[i])
+        {
+            glDeleteVertexArrays(1, vaos[i]);
+            glDeleteBuffers(1, vbos[i]);
+            *vaos[i] = 0;
         }
-        glBindVertexArray(waveVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, waveVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 5 * size_of_vertex, (vertexBuffer.data()), GL_STATIC_DRAW);
-
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *) 0);
-        glEnableVertexAttribArray(0);
-
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *) (3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-
-        //draw:
-        glBindVertexArray(waveVAO);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, size_of_vertex);
-        glBindVertexArray(0);
+    if (seaEBO)
+    {
+        glDeleteBuffers(1, &seaEBO);
+        seaEBO = 0;
     }
 }
 
@@ -627,6 +1283,26 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
     camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
 
+// writes the color attachment of the bound framebuffer as a binary PPM image
+// --------------------------------------------------------------------------
+void save_framebuffer_ppm(const char *path, int width, int height)
+{
+    std::vector<unsigned char> pixels(width * height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        std::cout << "Failed to write image: " << path << std::endl;
+        return;
+    }
+    out << "P6\n" << width << " " << height << "\n255\n";
+    // GL rows go bottom to top
+    for (int y = height - 1; y >= 0; y--)
+        out.write((const char *)&pixels[y * width * 3], width * 3);
+}
+
 // utility function for loading a 2D texture from file
 // ---------------------------------------------------
 unsigned int loadTexture(char const * path)
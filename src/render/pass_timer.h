@@ -0,0 +1,83 @@
+#ifndef PASS_TIMER_H
+#define PASS_TIMER_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "sim/frame_stats.h"
+
+// Number of timer queries per pass in flight; a result is read back this many frames later at the latest
+#define PASS_TIMER_QUERIES 4
+
+// CPU and GPU time of one render pass per frame. The GPU time comes from a GL_TIME_ELAPSED
+// query around the pass. Its result is only read once the GL reports it available, a frame
+// or more later, so timing never stalls the pipeline: every pass cycles through a small pool
+// of queries, and a query whose result is still missing when its turn comes again is
+// dropped rather than waited for. Elapsed-time queries cannot nest, so the passes timed
+// must not overlap.
+class PassTimer
+{
+public:
+    FrameStats cpu;
+    FrameStats gpu;
+    int dropped;        // queries recycled before their result arrived
+
+    PassTimer() : dropped(0), next(0), cpuStart(0)
+    {
+        for (int i = 0; i < PASS_TIMER_QUERIES; i++)
+        {
+            queries[i] = 0;
+            pending[i] = false;
+        }
+    }
+
+    // starts timing the pass; the GL context must be current
+    void begin()
+    {
+        if (queries[0] == 0)
+            glGenQueries(PASS_TIMER_QUERIES, queries);
+        collect();
+        if (pending[next])
+        {
+            pending[next] = false;
+            dropped++;
+        }
+        glBeginQuery(GL_TIME_ELAPSED, queries[next]);
+        cpuStart = glfwGetTime();
+    }
+
+    void end()
+    {
+        cpu.add((float)((glfwGetTime() - cpuStart) * 1000.0));
+        glEndQuery(GL_TIME_ELAPSED);
+        pending[next] = true;
+        next = (next + 1) % PASS_TIMER_QUERIES;
+    }
+
+    // moves the results that have arrived into gpu, oldest first, without waiting for the others
+    void collect()
+    {
+        for (int k = 0; k < PASS_TIMER_QUERIES; k++)
+        {
+            int i = (next + k) % PASS_TIMER_QUERIES;
+            if (!pending[i])
+                continue;
+            GLint available = 0;
+            glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                break;
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &ns);
+            gpu.add((float)(ns / 1e6));
+            pending[i] = false;
+        }
+    }
+
+private:
+    GLuint queries[PASS_TIMER_QUERIES];
+    bool pending[PASS_TIMER_QUERIES];
+    int next;
+    double cpuStart;
+};
+
+#endif
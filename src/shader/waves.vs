@@ -8,8 +8,68 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// gpu waves: aPos.xz is a static grid vertex (xi,zi) and the wave height, the sea
+// normal and the lightmap coordinates are computed here, as ocean_sim does on the cpu
+uniform bool gpuWaves;
+uniform float timer;
+uniform int octaves;
+uniform float speed;
+uniform float wavesize;
+uniform float vtxsize;
+uniform float level;
+uniform float quadsize;
+uniform float texdivider;
+uniform vec4 lightPlane;    // unit normal and d of the plane hit by the sea normal
+uniform bool flatten;       // lay the vertex on the floor at floorY
+uniform float floorY;
+
+// 2*pi split in an 8 bit head and a tail, so phases of 1e5 rad reduce accurately
+const float TWO_PI_HI = 6.28125;
+const float TWO_PI_LO = 1.9353071795864769e-3;
+const float INV_TWO_PI = 0.15915494309189535;
+
+float wave_height(float x, float z)
+{
+    float y = level;
+    float factor = 1.0;
+    float d = sqrt(x * x + z * z);
+    d = clamp(d / 40.0, 0.0, 1.5);
+    for (int i = 0; i < octaves; i++)
+    {
+        float a = (timer * speed) + (1.0 / factor) * x * z * wavesize;
+        float k = floor(a * INV_TWO_PI + 0.5);
+        a = (a - k * TWO_PI_HI) - k * TWO_PI_LO;
+        y -= factor * vtxsize * d * cos(a) + factor * vtxsize * d * sin(a);
+        factor = factor / 2.0;
+    }
+    return y;
+}
+
 void main()
 {
-    TexCoords = aTexCoords;    
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-}
\ No newline at end of file
+    if (!gpuWaves)
+    {
+        TexCoords = aTexCoords;
+        gl_Position = projection * view * model * vec4(aPos, 1.0);
+        return;
+    }
+
+    float xi = aPos.x;
+    float zi = aPos.z;
+    float h = wave_height(xi, zi);
+    vec3 p = vec3(xi * quadsize, h, zi * quadsize);
+    // sea normal e1^e2 towards the next vertices in x and z
+    vec3 e1 = vec3(quadsize, wave_height(xi + 1.0, zi) - h, 0.0);
+    vec3 e2 = vec3(0.0, wave_height(xi, zi + 1.0) - h, quadsize);
+    vec3 n = cross(e1, e2);
+
+    vec3 res = p;
+    float f = dot(n, lightPlane.xyz);
+    if (f != 0.0)
+        res = p - n * ((dot(lightPlane.xyz, p) + lightPlane.w) / f);
+    TexCoords = res.xz / texdivider;
+
+    if (flatten)
+        p.y = floorY;
+    gl_Position = projection * view * model * vec4(p, 1.0);
+}
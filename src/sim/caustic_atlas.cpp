@@ -0,0 +1,167 @@
+#include <math.h>
+#include <string.h>
+#include "wave_table.h"
+#include "fast_math.h"
+#include "caustic_atlas.h"
+
+// magic, version, size, frames, period, the grid's xfield, zfield, quadsize and
+// texdivider and the waves' octaves, speed, wavesize, vtxsize and level, four bytes each
+#define HEADER_BYTES 56
+
+
+float wave_period(const WaveParams &w)
+{
+    return (float)(2 * FM_PI / w.speed);
+}
+
+
+void caustic_atlas_bake(const SeaGrid &g, const WaveParams &w, const CausticParams &p, int frames,
+                        std::vector<unsigned char> &bytes, JobSystem *jobs)
+{
+    int texels = p.size * p.size;
+    bytes.resize((size_t)frames * texels);
+    WaveTable table;
+    wave_table_build(table, g, w, jobs);
+    std::vector<float> heights(sea_vertices(g)), normals(3 * sea_vertices(g));
+    CausticMap map;
+    float period = wave_period(w);
+    for (int i = 0; i < frames; i++)
+    {
+        wave_table_heights(table, w, i * period / frames, heights.data(), jobs);
+        sea_normals(g, heights.data(), normals.data(), jobs);
+        caustics_photons(g, heights.data(), normals.data(), p, map, jobs);
+        caustic_map_bytes(map, p, &bytes[(size_t)i * texels], jobs);
+    }
+}
+
+
+static void put_u32(unsigned char *b, unsigned int v)
+{
+    b[0] = v & 0xff;
+    b[1] = (v >> 8) & 0xff;
+    b[2] = (v >> 16) & 0xff;
+    b[3] = (v >> 24) & 0xff;
+}
+
+
+static unsigned int get_u32(const unsigned char *b)
+{
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((unsigned int)b[3] << 24);
+}
+
+
+static void put_f32(unsigned char *b, float v)
+{
+    unsigned int u;
+    memcpy(&u, &v, 4);
+    put_u32(b, u);
+}
+
+
+static float get_f32(const unsigned char *b)
+{
+    unsigned int u = get_u32(b);
+    float v;
+    memcpy(&v, &u, 4);
+    return v;
+}
+
+
+bool caustic_atlas_matches(const CausticAtlasHeader &h, const SeaGrid &g, const WaveParams &w)
+{
+    return h.grid.xfield == g.xfield && h.grid.zfield == g.zfield && h.grid.quadsize == g.quadsize &&
+           h.grid.texdivider == g.texdivider && h.wave.octaves == w.octaves && h.wave.speed == w.speed &&
+           h.wave.wavesize == w.wavesize && h.wave.vtxsize == w.vtxsize && h.wave.level == w.level;
+}
+
+
+bool caustic_atlas_write(const char *path, const CausticAtlasHeader &h, const unsigned char *bytes)
+{
+    unsigned char head[HEADER_BYTES];
+    memcpy(head, CAUSTIC_ATLAS_MAGIC, 4);
+    put_u32(head + 4, CAUSTIC_ATLAS_VERSION);
+    put_u32(head + 8, h.size);
+    put_u32(head + 12, h.frames);
+    put_f32(head + 16, h.period);
+    put_u32(head + 20, h.grid.xfield);
+    put_u32(head + 24, h.grid.zfield);
+    put_f32(head + 28, h.grid.quadsize);
+    put_f32(head + 32, h.grid.texdivider);
+    put_u32(head + 36, h.wave.octaves);
+    put_f32(head + 40, h.wave.speed);
+    put_f32(head + 44, h.wave.wavesize);
+    put_f32(head + 48, h.wave.vtxsize);
+    put_f32(head + 52, h.wave.level);
+
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return false;
+    size_t n = (size_t)h.frames * h.size * h.size;
+    bool ok = fwrite(head, 1, HEADER_BYTES, f) == HEADER_BYTES && fwrite(bytes, 1, n, f) == n;
+    return fclose(f) == 0 && ok;
+}
+
+
+bool CausticAtlasReader::open(const char *path, const SeaGrid &g, const WaveParams &w)
+{
+    close();
+    file = fopen(path, "rb");
+    if (!file)
+        return false;
+    unsigned char b[HEADER_BYTES];
+    if (fread(b, 1, HEADER_BYTES, file) != HEADER_BYTES || memcmp(b, CAUSTIC_ATLAS_MAGIC, 4) != 0 ||
+        get_u32(b + 4) != CAUSTIC_ATLAS_VERSION)
+    {
+        close();
+        return false;
+    }
+    head.size = get_u32(b + 8);
+    head.frames = get_u32(b + 12);
+    head.period = get_f32(b + 16);
+    head.grid.xfield = get_u32(b + 20);
+    head.grid.zfield = get_u32(b + 24);
+    head.grid.quadsize = get_f32(b + 28);
+    head.grid.texdivider = get_f32(b + 32);
+    head.wave.octaves = get_u32(b + 36);
+    head.wave.speed = get_f32(b + 40);
+    head.wave.wavesize = get_f32(b + 44);
+    head.wave.vtxsize = get_f32(b + 48);
+    head.wave.level = get_f32(b + 52);
+    // the frames must all be there, traced for this sea
+    long bytes = (long)head.frames * head.size * head.size;
+    if (head.size <= 0 || head.frames <= 0 || !(head.period > 0) || !caustic_atlas_matches(head, g, w) ||
+        fseek(file, 0, SEEK_END) != 0 || ftell(file) < HEADER_BYTES + bytes)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+
+void CausticAtlasReader::close()
+{
+    if (file)
+        fclose(file);
+    file = NULL;
+    head = CausticAtlasHeader();
+}
+
+
+int CausticAtlasReader::frame_at(float t) const
+{
+    double phase = fmod((double)t, (double)head.period);
+    if (phase < 0)
+        phase += head.period;
+    int i = (int)(phase / head.period * head.frames + 0.5);
+    return i % head.frames;
+}
+
+
+bool CausticAtlasReader::read_frame(int i, unsigned char *out)
+{
+    if (!file || i < 0 || i >= head.frames)
+        return false;
+    size_t n = (size_t)head.size * head.size;
+    return fseek(file, HEADER_BYTES + (long)i * n, SEEK_SET) == 0 && fread(out, 1, n, file) == n;
+}
@@ -0,0 +1,75 @@
+#ifndef _CAUSTIC_ATLAS_INC
+#define _CAUSTIC_ATLAS_INC
+
+#include <stdio.h>
+#include <vector>
+#include "sea.h"
+#include "caustics.h"
+#include "jobs.h"
+
+// Baked caustics: a looping sequence of caustic lightmaps (caustic_map_bytes()
+// format, one byte per texel) stored one after the other in a file, so a
+// viewer can replay them instead of tracing photons every frame. The trig wave
+// model only moves through the time phase timer*speed, so it repeats exactly
+// every 2*pi/speed ms and a sequence baked over that period loops seamlessly.
+//
+// File layout, little endian: the header below, then frames * size * size
+// bytes, frame after frame. Frame i shows the sea at i * period / frames ms.
+// The header also records the grid and wave settings of the bake: the
+// lightmaps only line up with a sea of the same extent and waves.
+
+#define CAUSTIC_ATLAS_MAGIC "OCAT"
+#define CAUSTIC_ATLAS_VERSION 2
+
+struct CausticAtlasHeader
+{
+    int size = 0;               // texels per side of every frame
+    int frames = 0;
+    float period = 0;           // ms covered by the whole sequence
+    SeaGrid grid;               // sea and trig waves the frames were traced for
+    WaveParams wave;
+};
+
+// true when an atlas with header h was baked for grid g and waves w
+bool caustic_atlas_matches(const CausticAtlasHeader &h, const SeaGrid &g, const WaveParams &w);
+
+// period of the trig wave model in ms
+float wave_period(const WaveParams &w);
+
+// traces frames lightmaps of the trig waves over one wave_period() into bytes
+// (frames * p.size * p.size)
+void caustic_atlas_bake(const SeaGrid &g, const WaveParams &w, const CausticParams &p, int frames,
+                        std::vector<unsigned char> &bytes, JobSystem *jobs = NULL);
+
+// writes a whole atlas; false if the file could not be written
+bool caustic_atlas_write(const char *path, const CausticAtlasHeader &h, const unsigned char *bytes);
+
+// Streams frames out of an atlas file: only the header is read on open, and
+// every read_frame() loads a single frame.
+class CausticAtlasReader
+{
+public:
+    CausticAtlasReader() : file(NULL) {}
+    ~CausticAtlasReader() { close(); }
+
+    // false if the file is missing, not an atlas, truncated or baked for
+    // another grid or other waves than g and w
+    bool open(const char *path, const SeaGrid &g, const WaveParams &w);
+    void close();
+    bool is_open() const { return file != NULL; }
+    const CausticAtlasHeader &header() const { return head; }
+
+    // frame shown at time t (ms), wrapping around the period
+    int frame_at(float t) const;
+    // reads frame i into out[size*size]
+    bool read_frame(int i, unsigned char *out);
+
+private:
+    CausticAtlasReader(const CausticAtlasReader &);
+    CausticAtlasReader &operator=(const CausticAtlasReader &);
+
+    FILE *file;
+    CausticAtlasHeader head;
+};
+
+#endif
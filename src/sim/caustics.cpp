@@ -0,0 +1,314 @@
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "fast_math.h"
+#include "vec3.h"
+#include "caustics.h"
+
+// lightmap rows handed to a job at a time
+#define CAUSTIC_GRAIN 16
+
+
+// world extent of the grid, shared by the photons, the lightmap and the floor uvs
+struct CausticExtent
+{
+    float x0, z0;               // corner of vertex (-xfield, -zfield)
+    float wx, wz;               // size along x and z
+};
+
+
+static CausticExtent caustic_extent(const SeaGrid &g)
+{
+    CausticExtent e;
+    e.x0 = -g.xfield * g.quadsize;
+    e.z0 = -g.zfield * g.quadsize;
+    e.wx = (sea_width(g) - 1) * g.quadsize;
+    e.wz = (sea_depth(g) - 1) * g.quadsize;
+    return e;
+}
+
+
+// direction of the light after refraction into the water at a point whose sea
+// normal (sea_normals() convention, pointing down, any length) is n; from air
+// into water there is no total internal reflection
+static inline vec3f refract_light(vec3f n, const vec3f &light, float eta)
+{
+    n = n * -fast_rsqrt<MATH_FAST>(length_sq(n));
+    float cosi = -dot(n, light);
+    float k2 = 1 - eta * eta * (1 - cosi * cosi);
+    return light * eta + n * (eta * cosi - sqrtf(k2 > 0 ? k2 : 0));
+}
+
+
+static inline void splat(float *tile, int size, int i, int j, float e)
+{
+    if (i >= 0 && i < size && j >= 0 && j < size)
+        tile[j * size + i] += e;
+}
+
+
+void caustics_photons(const SeaGrid &g, const float *heights, const float *normals, const CausticParams &p,
+                      CausticMap &map, JobSystem *jobs)
+{
+    int size = p.size;
+    int texels = size * size;
+    // one private lightmap per thread, and never more than one per photon row
+    int tasks = jobs ? std::min(jobs->threads(), p.photons) : 1;
+    map.size = size;
+    map.energy.resize(texels);
+    map.tiles.resize((size_t)tasks * texels);
+
+    CausticExtent ext = caustic_extent(g);
+    int depth = sea_depth(g);
+    float sx = ext.wx / p.photons, sz = ext.wz / p.photons;     // photon spacing
+    float tx = size / ext.wx, tz = size / ext.wz;               // texels per world unit
+    // each photon carries its share of the flat-sea energy, 1 per texel
+    float energy = (sx * tx) * (sz * tz);
+    vec3f light = normalize(vec3f(p.lightx, p.lighty, p.lightz));
+    float eta = 1 / p.ior;
+
+    parallel_for(jobs, 0, tasks, 1, [&](int first, int last) {
+        for (int task = first; task < last; task++)
+        {
+            float *tile = &map.tiles[(size_t)task * texels];
+            std::fill(tile, tile + texels, 0.0f);
+            int row0 = (int)((long long)p.photons * task / tasks);
+            int row1 = (int)((long long)p.photons * (task + 1) / tasks);
+            for (int pi = row0; pi < row1; pi++)
+            {
+                // the quad of the grid under the photon, and the position inside it
+                float x = (pi + 0.5f) * sx;
+                float fx = x / g.quadsize;
+                int ix = std::min((int)fx, sea_width(g) - 2);
+                float ax = fx - ix;
+                for (int pj = 0; pj < p.photons; pj++)
+                {
+                    float z = (pj + 0.5f) * sz;
+                    float fz = z / g.quadsize;
+                    int iz = std::min((int)fz, depth - 2);
+                    float az = fz - iz;
+                    int k = ix * depth + iz;
+                    float w00 = (1 - ax) * (1 - az), w10 = ax * (1 - az), w01 = (1 - ax) * az, w11 = ax * az;
+                    float h = w00 * heights[k] + w10 * heights[k + depth] + w01 * heights[k + 1] +
+                              w11 * heights[k + depth + 1];
+                    vec3f n = vec3_load(&normals[3 * k]) * w00 + vec3_load(&normals[3 * (k + depth)]) * w10 +
+                              vec3_load(&normals[3 * (k + 1)]) * w01 + vec3_load(&normals[3 * (k + depth + 1)]) * w11;
+                    vec3f t = refract_light(n, light, eta);
+                    if (t.y >= 0)
+                        continue;
+                    float d = (p.floor_y - h) / t.y;
+                    // bilinear splat around the four nearest texel centres
+                    float u = (x + t.x * d) * tx - 0.5f;
+                    float v = (z + t.z * d) * tz - 0.5f;
+                    float fu = floorf(u), fv = floorf(v);
+                    int i = (int)fu, j = (int)fv;
+                    float bu = u - fu, bv = v - fv;
+                    splat(tile, size, i, j, (1 - bu) * (1 - bv) * energy);
+                    splat(tile, size, i + 1, j, bu * (1 - bv) * energy);
+                    splat(tile, size, i, j + 1, (1 - bu) * bv * energy);
+                    splat(tile, size, i + 1, j + 1, bu * bv * energy);
+                }
+            }
+        }
+    });
+
+    // sum the private maps
+    parallel_for(jobs, 0, size, CAUSTIC_GRAIN, [&](int first, int last) {
+        int begin = first * size, end = last * size;
+        std::copy(map.tiles.begin() + begin, map.tiles.begin() + end, map.energy.begin() + begin);
+        for (int task = 1; task < tasks; task++)
+        {
+            const float *tile = &map.tiles[(size_t)task * texels];
+            for (int t = begin; t < end; t++)
+                map.energy[t] += tile[t];
+        }
+    });
+}
+
+
+void caustic_map_bytes(const CausticMap &map, const CausticParams &p, unsigned char *out, JobSystem *jobs)
+{
+    parallel_for(jobs, 0, map.size, CAUSTIC_GRAIN, [&](int first, int last) {
+        for (int t = first * map.size; t < last * map.size; t++)
+        {
+            float v = p.gain * (map.energy[t] - p.bias);
+            out[t] = (unsigned char)(std::min(std::max(v, 0.0f), 1.0f) * 255.0f + 0.5f);
+        }
+    });
+}
+
+
+void sea_floor_uvs(const SeaGrid &g, float *uvs, JobSystem *jobs)
+{
+    CausticExtent ext = caustic_extent(g);
+    parallel_for(jobs, -g.xfield, g.xfield + 2, CAUSTIC_GRAIN, [&](int first, int last) {
+        for (int xi = first; xi < last; xi++)
+            for (int zi = -g.zfield; zi <= g.zfield + 1; zi++)
+            {
+                int k = sea_index(g, xi, zi);
+                uvs[2 * k] = (xi * g.quadsize - ext.x0) / ext.wx;
+                uvs[2 * k + 1] = (zi * g.quadsize - ext.z0) / ext.wz;
+            }
+    });
+}
+
+
+// one grid column of caustics_refract(), with the sea normals split into components
+struct RefractColumn
+{
+    const float *h, *nx, *ny, *nz;
+    float x, z0, step;          // world x of the column, z of its first vertex and the z step
+    int n;
+    float *rx, *rz;
+};
+
+
+struct RefractLight
+{
+    float lx, ly, lz;           // unit direction of the light
+    float eta;
+    float floor_y;
+};
+
+
+static void refract_column_scalar(const RefractLight &l, const RefractColumn &c, int i)
+{
+    vec3f light(l.lx, l.ly, l.lz);
+    for (; i < c.n; i++)
+    {
+        vec3f t = refract_light(vec3f(c.nx[i], c.ny[i], c.nz[i]), light, l.eta);
+        float d = (l.floor_y - c.h[i]) / (t.y < -1e-6f ? t.y : -1e-6f);
+        c.rx[i] = c.x + t.x * d;
+        c.rz[i] = (c.z0 + i * c.step) + t.z * d;
+    }
+}
+
+
+#ifdef OCEAN_SIMD_X86
+
+static void refract_column_sse2(const RefractLight &l, const RefractColumn &c, int i)
+{
+    const __m128 lx = _mm_set1_ps(l.lx), ly = _mm_set1_ps(l.ly), lz = _mm_set1_ps(l.lz);
+    const __m128 eta = _mm_set1_ps(l.eta), one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+    for (; i + 4 <= c.n; i += 4)
+    {
+        __m128 nx = _mm_loadu_ps(c.nx + i), ny = _mm_loadu_ps(c.ny + i), nz = _mm_loadu_ps(c.nz + i);
+        // upward unit normal
+        __m128 s = _mm_sub_ps(zero, fast_rsqrt_sse2<MATH_FAST>(
+                                        _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz))));
+        nx = _mm_mul_ps(nx, s);
+        ny = _mm_mul_ps(ny, s);
+        nz = _mm_mul_ps(nz, s);
+        __m128 cosi = _mm_sub_ps(zero, _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, lx), _mm_mul_ps(ny, ly)), _mm_mul_ps(nz, lz)));
+        __m128 k2 = _mm_sub_ps(one, _mm_mul_ps(_mm_mul_ps(eta, eta), _mm_sub_ps(one, _mm_mul_ps(cosi, cosi))));
+        __m128 a = _mm_sub_ps(_mm_mul_ps(eta, cosi), _mm_sqrt_ps(_mm_max_ps(k2, zero)));
+        __m128 tx = _mm_add_ps(_mm_mul_ps(lx, eta), _mm_mul_ps(nx, a));
+        __m128 ty = _mm_add_ps(_mm_mul_ps(ly, eta), _mm_mul_ps(ny, a));
+        __m128 tz = _mm_add_ps(_mm_mul_ps(lz, eta), _mm_mul_ps(nz, a));
+        __m128 d = _mm_div_ps(_mm_sub_ps(_mm_set1_ps(l.floor_y), _mm_loadu_ps(c.h + i)),
+                              _mm_min_ps(ty, _mm_set1_ps(-1e-6f)));
+        __m128 z = _mm_add_ps(_mm_set1_ps(c.z0), _mm_mul_ps(_mm_set_ps(i + 3, i + 2, i + 1, i), _mm_set1_ps(c.step)));
+        _mm_storeu_ps(c.rx + i, _mm_add_ps(_mm_set1_ps(c.x), _mm_mul_ps(tx, d)));
+        _mm_storeu_ps(c.rz + i, _mm_add_ps(z, _mm_mul_ps(tz, d)));
+    }
+    refract_column_scalar(l, c, i);
+}
+
+
+OCEAN_TARGET_AVX2
+static void refract_column_avx2(const RefractLight &l, const RefractColumn &c)
+{
+    const __m256 lx = _mm256_set1_ps(l.lx), ly = _mm256_set1_ps(l.ly), lz = _mm256_set1_ps(l.lz);
+    const __m256 eta = _mm256_set1_ps(l.eta), one = _mm256_set1_ps(1.0f), zero = _mm256_setzero_ps();
+    const __m256 lanes = _mm256_set_ps(7, 6, 5, 4, 3, 2, 1, 0);
+    int i = 0;
+    for (; i + 8 <= c.n; i += 8)
+    {
+        __m256 nx = _mm256_loadu_ps(c.nx + i), ny = _mm256_loadu_ps(c.ny + i), nz = _mm256_loadu_ps(c.nz + i);
+        __m256 s = _mm256_sub_ps(zero, fast_rsqrt_avx2<MATH_FAST>(_mm256_add_ps(
+                                           _mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)), _mm256_mul_ps(nz, nz))));
+        nx = _mm256_mul_ps(nx, s);
+        ny = _mm256_mul_ps(ny, s);
+        nz = _mm256_mul_ps(nz, s);
+        __m256 cosi = _mm256_sub_ps(
+            zero, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, lx), _mm256_mul_ps(ny, ly)), _mm256_mul_ps(nz, lz)));
+        __m256 k2 = _mm256_sub_ps(one, _mm256_mul_ps(_mm256_mul_ps(eta, eta), _mm256_sub_ps(one, _mm256_mul_ps(cosi, cosi))));
+        __m256 a = _mm256_sub_ps(_mm256_mul_ps(eta, cosi), _mm256_sqrt_ps(_mm256_max_ps(k2, zero)));
+        __m256 tx = _mm256_add_ps(_mm256_mul_ps(lx, eta), _mm256_mul_ps(nx, a));
+        __m256 ty = _mm256_add_ps(_mm256_mul_ps(ly, eta), _mm256_mul_ps(ny, a));
+        __m256 tz = _mm256_add_ps(_mm256_mul_ps(lz, eta), _mm256_mul_ps(nz, a));
+        __m256 d = _mm256_div_ps(_mm256_sub_ps(_mm256_set1_ps(l.floor_y), _mm256_loadu_ps(c.h + i)),
+                                 _mm256_min_ps(ty, _mm256_set1_ps(-1e-6f)));
+        __m256 z = _mm256_add_ps(_mm256_set1_ps(c.z0),
+                                 _mm256_mul_ps(_mm256_add_ps(_mm256_set1_ps((float)i), lanes), _mm256_set1_ps(c.step)));
+        _mm256_storeu_ps(c.rx + i, _mm256_add_ps(_mm256_set1_ps(c.x), _mm256_mul_ps(tx, d)));
+        _mm256_storeu_ps(c.rz + i, _mm256_add_ps(z, _mm256_mul_ps(tz, d)));
+    }
+    refract_column_sse2(l, c, i);
+}
+
+#endif
+
+
+void caustics_refract(const SeaGrid &g, const float *heights, const float *normals, const CausticParams &p,
+                      CausticRefraction &r, JobSystem *jobs)
+{
+    r.x.resize(sea_vertices(g));
+    r.z.resize(sea_vertices(g));
+    int depth = sea_depth(g);
+    vec3f light = normalize(vec3f(p.lightx, p.lighty, p.lightz));
+    RefractLight l = {light.x, light.y, light.z, 1 / p.ior, p.floor_y};
+    parallel_for(jobs, -g.xfield, g.xfield + 2, CAUSTIC_GRAIN, [&](int first, int last) {
+        std::vector<float> nx(depth), ny(depth), nz(depth);
+        for (int xi = first; xi < last; xi++)
+        {
+            int base = sea_index(g, xi, -g.zfield);
+            vec3_soa_split(&normals[3 * base], depth, nx.data(), ny.data(), nz.data());
+            RefractColumn c = {&heights[base], nx.data(), ny.data(), nz.data(), xi * g.quadsize,
+                               -g.zfield * g.quadsize, g.quadsize, depth, &r.x[base], &r.z[base]};
+#ifdef OCEAN_SIMD_X86
+            switch (simd_path())
+            {
+                case SIMD_AVX2: refract_column_avx2(l, c); continue;
+                case SIMD_SSE2: refract_column_sse2(l, c, 0); continue;
+                default: break;
+            }
+#endif
+            refract_column_scalar(l, c, 0);
+        }
+    });
+}
+
+
+void caustics_area_mesh(const SeaGrid &g, const CausticRefraction &r, const CausticParams &p, float mesh_y,
+                        float *out, JobSystem *jobs)
+{
+    int rows = sea_mesh_rows(g);
+    int depth = sea_depth(g);
+    float area = g.quadsize * g.quadsize;
+    parallel_for(jobs, -g.xfield, g.xfield + 1, CAUSTIC_GRAIN, [&](int first, int last) {
+        for (int xi = first; xi < last; xi++)
+        {
+            float *v = out + 5 * (xi + g.xfield) * rows;
+            int base = sea_index(g, xi, -g.zfield);
+            const float *x0 = &r.x[base], *z0 = &r.z[base];
+            const float *x1 = x0 + depth, *z1 = z0 + depth;
+            for (int k = 0; k < rows; k++)
+            {
+                // the quad ahead of the vertex after refraction: half the cross
+                // product of its diagonals, whichever way it is folded
+                float ax = x1[k + 1] - x0[k], az = z1[k + 1] - z0[k];
+                float bx = x0[k + 1] - x1[k], bz = z0[k + 1] - z1[k];
+                float projected = 0.5f * fabsf(ax * bz - az * bx);
+                float ratio = area / (projected > 1e-12f ? projected : 1e-12f);
+                float u = p.gain * (ratio - p.bias);
+                v[0] = x0[k];
+                v[1] = mesh_y;
+                v[2] = z0[k];
+                v[3] = u < 0 ? 0 : u > 1 ? 1 : u;
+                v[4] = 0.5f;
+                v += 5;
+            }
+        }
+    });
+}
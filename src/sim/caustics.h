@@ -0,0 +1,80 @@
+#ifndef _CAUSTICS_INC
+#define _CAUSTICS_INC
+
+#include <stddef.h>
+#include <vector>
+#include "sea.h"
+#include "jobs.h"
+
+// Photon caustics: a regular grid of light rays is refracted through the sea
+// surface with Snell's law, each refracted ray is intersected with the seabed
+// plane y = floor_y and its energy is splatted bilinearly into a lightmap that
+// covers the world extent of the sea grid. Where the waves focus the light the
+// photons crowd together and the map gets brighter than the flat-sea level of 1.
+//
+// The photon rows are split over the threads of the job system, each with a
+// private copy of the lightmap, so no two threads ever write the same texel.
+// The copies are then summed texel row by texel row, also in parallel. Both
+// stages are independent of the photon order, so the work and the result scale
+// with the threads and not with contention.
+
+struct CausticParams
+{
+    int photons = 512;          // photons per side of the emission grid over the sea
+    int size = 256;             // lightmap texels per side
+    float lightx = 0.2f;        // direction of the incoming light, need not be normalized
+    float lighty = -1.0f;
+    float lightz = 0.1f;
+    float ior = 1.33f;          // index of refraction of the water
+    float floor_y = 0;          // height of the seabed
+    float gain = 0.6f;          // brightness clamp(gain * (energy - bias)) of the light reaching the seabed
+    float bias = 0.8f;
+};
+
+// energy[j*size + i] of texel (i,j): i runs along x and j along z over
+// [-xfield*quadsize, (xfield+1)*quadsize] x [-zfield*quadsize, (zfield+1)*quadsize]
+struct CausticMap
+{
+    int size = 0;
+    std::vector<float> energy;
+    std::vector<float> tiles;   // private maps of the threads, kept between frames
+};
+
+// traces the photons through heights[sea_vertices] and the sea normals
+// normals[3*sea_vertices] (sea_normals() convention) into map
+void caustics_photons(const SeaGrid &g, const float *heights, const float *normals, const CausticParams &p,
+                      CausticMap &map, JobSystem *jobs = NULL);
+
+// one byte per texel for upload as a single channel texture, after the
+// gain and bias of p: out[size*size]
+void caustic_map_bytes(const CausticMap &map, const CausticParams &p, unsigned char *out, JobSystem *jobs = NULL);
+
+// Area-ratio caustics, after Evan Wallace's WebGL water: the light refracted at
+// every grid vertex is followed down to the seabed, which moves the grid there.
+// Light is conserved, so a quad of the sea lights its projected quad with the
+// intensity area(original) / area(projected): 1 under a flat sea, more where the
+// waves focus it. One ray per vertex gives smooth caustics that photon splatting
+// needs many photons per texel to match.
+
+// where the light refracted at each grid vertex meets the seabed, sea_vertices each
+struct CausticRefraction
+{
+    std::vector<float> x, z;
+};
+
+void caustics_refract(const SeaGrid &g, const float *heights, const float *normals, const CausticParams &p,
+                      CausticRefraction &r, JobSystem *jobs = NULL);
+
+// the caustic mesh in the layout of sea_mesh(): every mesh vertex moved to its
+// refracted position at height mesh_y, u the intensity of the quad ahead of it
+// through the gain and bias of p, clamped to [0,1], and v = 0.5. Drawn with the
+// sea mesh indices and a texture that maps u to brightness, additive blending
+// sums the light of overlapping quads.
+void caustics_area_mesh(const SeaGrid &g, const CausticRefraction &r, const CausticParams &p, float mesh_y,
+                        float *out, JobSystem *jobs = NULL);
+
+// fills uvs[2*sea_vertices] with the lightmap coordinates of the seabed under
+// every vertex, for meshes that sample a CausticMap
+void sea_floor_uvs(const SeaGrid &g, float *uvs, JobSystem *jobs = NULL);
+
+#endif
@@ -0,0 +1,177 @@
+#include <string.h>
+#include <vector>
+#include "fast_math.h"
+
+
+const char *math_tier_name(MathTier tier)
+{
+    switch (tier)
+    {
+        case MATH_LIBM: return "libm";
+        case MATH_ACCURATE: return "accurate";
+        case MATH_FAST: return "fast";
+        case MATH_FASTEST: return "fastest";
+    }
+    return "?";
+}
+
+
+const char *math_function_name(MathFunction f)
+{
+    switch (f)
+    {
+        case MATH_SIN: return "sin";
+        case MATH_COS: return "cos";
+        case MATH_RSQRT: return "rsqrt";
+    }
+    return "?";
+}
+
+
+template <MathTier T>
+static void eval_scalar(MathFunction f, const float *x, float *y, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        float s, c;
+        if (f == MATH_RSQRT)
+            y[i] = fast_rsqrt<T>(x[i]);
+        else
+        {
+            fast_sincos<T>(x[i], &s, &c);
+            y[i] = f == MATH_SIN ? s : c;
+        }
+    }
+}
+
+
+#ifdef OCEAN_SIMD_X86
+
+template <MathTier T>
+static void eval_sse2(MathFunction f, const float *x, float *y, int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 v = _mm_loadu_ps(x + i);
+        __m128 s, c;
+        if (f == MATH_RSQRT)
+            _mm_storeu_ps(y + i, fast_rsqrt_sse2<T>(v));
+        else
+        {
+            fast_sincos_sse2<T>(v, &s, &c);
+            _mm_storeu_ps(y + i, f == MATH_SIN ? s : c);
+        }
+    }
+    eval_scalar<T>(f, x + i, y + i, n - i);
+}
+
+
+template <MathTier T>
+OCEAN_TARGET_AVX2 static void eval_avx2(MathFunction f, const float *x, float *y, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 v = _mm256_loadu_ps(x + i);
+        __m256 s, c;
+        if (f == MATH_RSQRT)
+            _mm256_storeu_ps(y + i, fast_rsqrt_avx2<T>(v));
+        else
+        {
+            fast_sincos_avx2<T>(v, &s, &c);
+            _mm256_storeu_ps(y + i, f == MATH_SIN ? s : c);
+        }
+    }
+    eval_scalar<T>(f, x + i, y + i, n - i);
+}
+
+#endif
+
+
+template <MathTier T>
+static void eval_tier(MathFunction f, SimdPath path, const float *x, float *y, int n)
+{
+#ifdef OCEAN_SIMD_X86
+    switch (path)
+    {
+        case SIMD_AVX2: eval_avx2<T>(f, x, y, n); return;
+        case SIMD_SSE2: eval_sse2<T>(f, x, y, n); return;
+        default: break;
+    }
+#endif
+    eval_scalar<T>(f, x, y, n);
+}
+
+
+static void eval(MathFunction f, MathTier tier, SimdPath path, const float *x, float *y, int n)
+{
+    switch (tier)
+    {
+        case MATH_LIBM: eval_tier<MATH_LIBM>(f, path, x, y, n); break;
+        case MATH_ACCURATE: eval_tier<MATH_ACCURATE>(f, path, x, y, n); break;
+        case MATH_FAST: eval_tier<MATH_FAST>(f, path, x, y, n); break;
+        case MATH_FASTEST: eval_tier<MATH_FASTEST>(f, path, x, y, n); break;
+    }
+}
+
+
+// float encodings ordered like the values: negative floats map below zero
+static long long float_order(float v)
+{
+    int i;
+    memcpy(&i, &v, sizeof(i));
+    return i < 0 ? -(long long)(i & 0x7fffffff) : i;
+}
+
+
+static float order_float(long long o)
+{
+    int i = o < 0 ? (int)(-o) | (int)0x80000000 : (int)o;
+    float v;
+    memcpy(&v, &i, sizeof(v));
+    return v;
+}
+
+
+MathAccuracy fast_math_accuracy(MathFunction f, MathTier tier, SimdPath path, float lo, float hi, int samples)
+{
+    MathAccuracy acc;
+    if (path > simd_detect())
+        path = simd_detect();
+    if (f == MATH_RSQRT && lo <= 0)
+        lo = 1e-30f;
+    long long first = float_order(lo), last = float_order(hi);
+    long long step = (last - first) / (samples > 1 ? samples : 1);
+    if (step < 1)
+        step = 1;
+
+    const int chunk = 4096;
+    std::vector<float> x(chunk), y(chunk);
+    for (long long o = first; o <= last;)
+    {
+        int n = 0;
+        for (; n < chunk && o <= last; n++, o += step)
+            x[n] = order_float(o);
+        eval(f, tier, path, x.data(), y.data(), n);
+        for (int i = 0; i < n; i++)
+        {
+            double ref = f == MATH_SIN ? sin((double)x[i]) : f == MATH_COS ? cos((double)x[i]) : 1 / sqrt((double)x[i]);
+            // one ulp is the spacing of floats at the correctly rounded result
+            float rf = fabsf((float)ref);
+            double ulp = rf > 0 ? (double)nextafterf(rf, INFINITY) - rf : 1.4e-45;
+            double err = fabs(y[i] - ref);
+            if (err / ulp > acc.max_ulp)
+            {
+                acc.max_ulp = err / ulp;
+                acc.worst = x[i];
+            }
+            if (err > acc.max_abs)
+                acc.max_abs = err;
+            if (ref != 0 && err / fabs(ref) > acc.max_rel)
+                acc.max_rel = err / fabs(ref);
+        }
+        acc.samples += n;
+    }
+    return acc;
+}
@@ -0,0 +1,332 @@
+#ifndef _FAST_MATH_INC
+#define _FAST_MATH_INC
+
+#include <math.h>
+#include "simd.h"
+
+#ifdef OCEAN_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// Polynomial sin/cos and reciprocal square root for the hot loops, in scalar
+// form and in SSE2/AVX2 forms that keep whole vectors in registers where a
+// libm call would not. Every function takes an accuracy tier as a template
+// argument:
+//   MATH_LIBM      libm sinf/cosf and 1/sqrtf (lane by lane in the vector
+//                  forms), the reference
+//   MATH_ACCURATE  sin/cos reduced by pi/2 in double precision with the
+//                  cephes sinf/cosf polynomials; rsqrt as 1/sqrt. Within a few
+//                  ulp of libm for |a| < 1e6. The quadrant is taken mod 4 in
+//                  double, so larger arguments up to 1e10 (8 octaves on the
+//                  largest sea grid reach 6.4e9) stay within 1e-6 absolute.
+//   MATH_FAST      same polynomials after a three part float reduction, valid
+//                  for |a| < 8192; rsqrt as the hardware estimate and one
+//                  Newton step
+//   MATH_FASTEST   two part float reduction (|a| < 100) and degree 5/4
+//                  polynomials, absolute error below 2e-5; rsqrt as the raw
+//                  hardware estimate, relative error below 4e-4
+// fast_math_accuracy() measures the actual errors against the exact result;
+// the bounds below hold on every simd path and are checked by fast_math_test.
+
+#define FM_RANGE_ACCURATE 1e6f              // sin/cos arguments over which the bounds below hold
+#define FM_RANGE_FAST 8192.0f
+#define FM_RANGE_FASTEST 100.0f
+#define FM_MAX_ULP_ACCURATE 2.0             // sin, cos and rsqrt of MATH_LIBM and MATH_ACCURATE
+#define FM_MAX_ULP_FAST_SINCOS 3.0
+#define FM_MAX_ULP_FAST_RSQRT 6.0
+#define FM_MAX_ABS_FASTEST_SINCOS 2e-5
+#define FM_MAX_REL_FASTEST_RSQRT 4e-4
+
+enum MathTier
+{
+    MATH_LIBM = 0,
+    MATH_ACCURATE,
+    MATH_FAST,
+    MATH_FASTEST
+};
+
+enum MathFunction
+{
+    MATH_SIN = 0,
+    MATH_COS,
+    MATH_RSQRT
+};
+
+struct MathAccuracy
+{
+    double max_ulp = 0;         // against libm in double precision, rounded to float
+    double max_abs = 0;
+    double max_rel = 0;
+    float worst = 0;            // argument of the largest ulp error
+    long long samples = 0;
+};
+
+const char *math_tier_name(MathTier tier);
+const char *math_function_name(MathFunction f);
+
+// error of f on tier over [lo, hi], evaluated on simd path. Arguments are
+// spread evenly over the float encodings of the range, so every binade is
+// covered; when the range holds at most samples floats every one is tested.
+MathAccuracy fast_math_accuracy(MathFunction f, MathTier tier, SimdPath path, float lo, float hi, int samples);
+
+
+// pi for the wave models, which work in double where it matters
+#define FM_PI 3.14159265358979323846
+
+// pi/2 split in a 33 bit head and a tail, so k*PIO2_HI is exact for any |k| < 2^20
+#define FM_PIO2_HI 1.57079632673412561417e+00
+#define FM_PIO2_LO 6.07710050650619224932e-11
+#define FM_TWO_OVER_PI 6.36619772367581382433e-01
+// adding and subtracting 1.5*2^52 rounds a double of magnitude below 2^51 to the nearest integer
+#define FM_ROUND_MAGIC 6755399441055744.0
+// pi/2 in float parts for the Cody-Waite reduction (cephes)
+#define FM_PIO2_F1 1.5703125f
+#define FM_PIO2_F2 4.837512969970703125e-4f
+#define FM_PIO2_F3 7.54978995489188216e-8f
+#define FM_TWO_OVER_PI_F 0.636619772367581343f
+
+// minimax polynomials of sin and cos on [-pi/4, pi/4] (cephes sinf/cosf)
+#define FM_SIN_P0 -1.9515295891e-4f
+#define FM_SIN_P1 8.3321608736e-3f
+#define FM_SIN_P2 -1.6666654611e-1f
+#define FM_COS_P0 2.443315711809948e-5f
+#define FM_COS_P1 -1.388731625493765e-3f
+#define FM_COS_P2 4.166664568298827e-2f
+// shorter fits for MATH_FASTEST: sin = r + r^3 (S1 + S2 r^2), cos = 1 + r^2 (C1 + C2 r^2)
+#define FM_SIN_S1 -1.6662835412681612e-1f
+#define FM_SIN_S2 8.15302933768445e-3f
+#define FM_COS_C1 -4.997763798001515e-1f
+#define FM_COS_C2 4.048912325726365e-2f
+
+
+template <MathTier T>
+inline void fast_sincos(float a, float *sin_a, float *cos_a)
+{
+    if (T == MATH_LIBM)
+    {
+        *sin_a = sinf(a);
+        *cos_a = cosf(a);
+        return;
+    }
+    float r;
+    int q;
+    if (T == MATH_ACCURATE)
+    {
+        double k = nearbyint(a * FM_TWO_OVER_PI);
+        r = (float)((a - k * FM_PIO2_HI) - k * FM_PIO2_LO);
+        // only k mod 4 matters, and k itself may be far out of int range
+        q = (int)(k - 4 * nearbyint(k * 0.25));
+    }
+    else
+    {
+        float k = nearbyintf(a * FM_TWO_OVER_PI_F);
+        r = a - k * FM_PIO2_F1 - k * FM_PIO2_F2;
+        if (T == MATH_FAST)
+            r = r - k * FM_PIO2_F3;
+        q = (int)k;
+    }
+    float r2 = r * r;
+    float s, c;
+    if (T == MATH_FASTEST)
+    {
+        s = (FM_SIN_S2 * r2 + FM_SIN_S1) * r2 * r + r;
+        c = (FM_COS_C2 * r2 + FM_COS_C1) * r2 + 1.0f;
+    }
+    else
+    {
+        s = ((FM_SIN_P0 * r2 + FM_SIN_P1) * r2 + FM_SIN_P2) * r2 * r + r;
+        c = ((FM_COS_P0 * r2 + FM_COS_P1) * r2 + FM_COS_P2) * r2 * r2 - 0.5f * r2 + 1.0f;
+    }
+    // odd quadrants swap sin and cos, quadrants 2,3 negate sin, quadrants 1,2 negate cos
+    float sn = q & 1 ? c : s;
+    float cs = q & 1 ? s : c;
+    *sin_a = q & 2 ? -sn : sn;
+    *cos_a = (q + 1) & 2 ? -cs : cs;
+}
+
+
+template <MathTier T>
+inline float fast_rsqrt(float x)
+{
+#ifdef OCEAN_SIMD_X86
+    if (T == MATH_FAST || T == MATH_FASTEST)
+    {
+        float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+        if (T == MATH_FAST)
+            y = y * (1.5f - 0.5f * x * y * y);
+        return y;
+    }
+#endif
+    return 1.0f / sqrtf(x);
+}
+
+
+#ifdef OCEAN_SIMD_X86
+
+template <MathTier T>
+inline void fast_sincos_sse2(__m128 a, __m128 *sin_a, __m128 *cos_a)
+{
+    if (T == MATH_LIBM)
+    {
+        float v[4], s[4], c[4];
+        _mm_storeu_ps(v, a);
+        for (int i = 0; i < 4; i++)
+            fast_sincos<MATH_LIBM>(v[i], &s[i], &c[i]);
+        *sin_a = _mm_loadu_ps(s);
+        *cos_a = _mm_loadu_ps(c);
+        return;
+    }
+    __m128 r;
+    __m128i q;
+    if (T == MATH_ACCURATE)
+    {
+        __m128d lo = _mm_cvtps_pd(a);
+        __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(a, a));
+        // k is rounded in double, it may be far out of int range; only k mod 4 is converted
+        const __m128d magic = _mm_set1_pd(FM_ROUND_MAGIC);
+        __m128d kdlo = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(lo, _mm_set1_pd(FM_TWO_OVER_PI)), magic), magic);
+        __m128d kdhi = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(hi, _mm_set1_pd(FM_TWO_OVER_PI)), magic), magic);
+        __m128d k4lo = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(kdlo, _mm_set1_pd(0.25)), magic), magic);
+        __m128d k4hi = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(kdhi, _mm_set1_pd(0.25)), magic), magic);
+        __m128i klo = _mm_cvtpd_epi32(_mm_sub_pd(kdlo, _mm_mul_pd(k4lo, _mm_set1_pd(4))));
+        __m128i khi = _mm_cvtpd_epi32(_mm_sub_pd(kdhi, _mm_mul_pd(k4hi, _mm_set1_pd(4))));
+        lo = _mm_sub_pd(_mm_sub_pd(lo, _mm_mul_pd(kdlo, _mm_set1_pd(FM_PIO2_HI))), _mm_mul_pd(kdlo, _mm_set1_pd(FM_PIO2_LO)));
+        hi = _mm_sub_pd(_mm_sub_pd(hi, _mm_mul_pd(kdhi, _mm_set1_pd(FM_PIO2_HI))), _mm_mul_pd(kdhi, _mm_set1_pd(FM_PIO2_LO)));
+        r = _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+        q = _mm_unpacklo_epi64(klo, khi);
+    }
+    else
+    {
+        q = _mm_cvtps_epi32(_mm_mul_ps(a, _mm_set1_ps(FM_TWO_OVER_PI_F)));
+        __m128 k = _mm_cvtepi32_ps(q);
+        r = _mm_sub_ps(a, _mm_mul_ps(k, _mm_set1_ps(FM_PIO2_F1)));
+        r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(FM_PIO2_F2)));
+        if (T == MATH_FAST)
+            r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(FM_PIO2_F3)));
+    }
+
+    __m128 r2 = _mm_mul_ps(r, r);
+    __m128 s, c;
+    if (T == MATH_FASTEST)
+    {
+        s = _mm_add_ps(_mm_mul_ps(r2, _mm_set1_ps(FM_SIN_S2)), _mm_set1_ps(FM_SIN_S1));
+        s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, r2), r), r);
+        c = _mm_add_ps(_mm_mul_ps(r2, _mm_set1_ps(FM_COS_C2)), _mm_set1_ps(FM_COS_C1));
+        c = _mm_add_ps(_mm_mul_ps(c, r2), _mm_set1_ps(1.0f));
+    }
+    else
+    {
+        s = _mm_add_ps(_mm_mul_ps(r2, _mm_set1_ps(FM_SIN_P0)), _mm_set1_ps(FM_SIN_P1));
+        s = _mm_add_ps(_mm_mul_ps(s, r2), _mm_set1_ps(FM_SIN_P2));
+        s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, r2), r), r);
+        c = _mm_add_ps(_mm_mul_ps(r2, _mm_set1_ps(FM_COS_P0)), _mm_set1_ps(FM_COS_P1));
+        c = _mm_add_ps(_mm_mul_ps(c, r2), _mm_set1_ps(FM_COS_P2));
+        c = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_mul_ps(c, r2), r2), _mm_mul_ps(r2, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+    }
+
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 sn = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+    __m128 cs = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+    *sin_a = _mm_xor_ps(sn, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30)));
+    *cos_a = _mm_xor_ps(cs, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30)));
+}
+
+
+template <MathTier T>
+inline __m128 fast_rsqrt_sse2(__m128 x)
+{
+    if (T == MATH_FAST || T == MATH_FASTEST)
+    {
+        __m128 y = _mm_rsqrt_ps(x);
+        if (T == MATH_FAST)
+            y = _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), x), _mm_mul_ps(y, y))));
+        return y;
+    }
+    return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(x));
+}
+
+
+template <MathTier T>
+OCEAN_TARGET_AVX2 inline void fast_sincos_avx2(__m256 a, __m256 *sin_a, __m256 *cos_a)
+{
+    if (T == MATH_LIBM)
+    {
+        float v[8], s[8], c[8];
+        _mm256_storeu_ps(v, a);
+        for (int i = 0; i < 8; i++)
+            fast_sincos<MATH_LIBM>(v[i], &s[i], &c[i]);
+        *sin_a = _mm256_loadu_ps(s);
+        *cos_a = _mm256_loadu_ps(c);
+        return;
+    }
+    __m256 r;
+    __m256i q;
+    if (T == MATH_ACCURATE)
+    {
+        __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(a));
+        __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(a, 1));
+        __m256d kdlo = _mm256_round_pd(_mm256_mul_pd(lo, _mm256_set1_pd(FM_TWO_OVER_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256d kdhi = _mm256_round_pd(_mm256_mul_pd(hi, _mm256_set1_pd(FM_TWO_OVER_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        lo = _mm256_sub_pd(_mm256_sub_pd(lo, _mm256_mul_pd(kdlo, _mm256_set1_pd(FM_PIO2_HI))), _mm256_mul_pd(kdlo, _mm256_set1_pd(FM_PIO2_LO)));
+        hi = _mm256_sub_pd(_mm256_sub_pd(hi, _mm256_mul_pd(kdhi, _mm256_set1_pd(FM_PIO2_HI))), _mm256_mul_pd(kdhi, _mm256_set1_pd(FM_PIO2_LO)));
+        r = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)), _mm256_cvtpd_ps(hi), 1);
+        // k may be far out of int range; only k mod 4 is converted
+        __m256d k4lo = _mm256_round_pd(_mm256_mul_pd(kdlo, _mm256_set1_pd(0.25)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256d k4hi = _mm256_round_pd(_mm256_mul_pd(kdhi, _mm256_set1_pd(0.25)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        kdlo = _mm256_sub_pd(kdlo, _mm256_mul_pd(k4lo, _mm256_set1_pd(4)));
+        kdhi = _mm256_sub_pd(kdhi, _mm256_mul_pd(k4hi, _mm256_set1_pd(4)));
+        q = _mm256_insertf128_si256(_mm256_castsi128_si256(_mm256_cvtpd_epi32(kdlo)), _mm256_cvtpd_epi32(kdhi), 1);
+    }
+    else
+    {
+        __m256 k = _mm256_round_ps(_mm256_mul_ps(a, _mm256_set1_ps(FM_TWO_OVER_PI_F)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        q = _mm256_cvtps_epi32(k);
+        r = _mm256_sub_ps(a, _mm256_mul_ps(k, _mm256_set1_ps(FM_PIO2_F1)));
+        r = _mm256_sub_ps(r, _mm256_mul_ps(k, _mm256_set1_ps(FM_PIO2_F2)));
+        if (T == MATH_FAST)
+            r = _mm256_sub_ps(r, _mm256_mul_ps(k, _mm256_set1_ps(FM_PIO2_F3)));
+    }
+
+    __m256 r2 = _mm256_mul_ps(r, r);
+    __m256 s, c;
+    if (T == MATH_FASTEST)
+    {
+        s = _mm256_add_ps(_mm256_mul_ps(r2, _mm256_set1_ps(FM_SIN_S2)), _mm256_set1_ps(FM_SIN_S1));
+        s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, r2), r), r);
+        c = _mm256_add_ps(_mm256_mul_ps(r2, _mm256_set1_ps(FM_COS_C2)), _mm256_set1_ps(FM_COS_C1));
+        c = _mm256_add_ps(_mm256_mul_ps(c, r2), _mm256_set1_ps(1.0f));
+    }
+    else
+    {
+        s = _mm256_add_ps(_mm256_mul_ps(r2, _mm256_set1_ps(FM_SIN_P0)), _mm256_set1_ps(FM_SIN_P1));
+        s = _mm256_add_ps(_mm256_mul_ps(s, r2), _mm256_set1_ps(FM_SIN_P2));
+        s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, r2), r), r);
+        c = _mm256_add_ps(_mm256_mul_ps(r2, _mm256_set1_ps(FM_COS_P0)), _mm256_set1_ps(FM_COS_P1));
+        c = _mm256_add_ps(_mm256_mul_ps(c, r2), _mm256_set1_ps(FM_COS_P2));
+        c = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(c, r2), r2), _mm256_mul_ps(r2, _mm256_set1_ps(0.5f))), _mm256_set1_ps(1.0f));
+    }
+
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+    __m256 sn = _mm256_blendv_ps(s, c, swap);
+    __m256 cs = _mm256_blendv_ps(c, s, swap);
+    *sin_a = _mm256_xor_ps(sn, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30)));
+    *cos_a = _mm256_xor_ps(cs, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30)));
+}
+
+
+template <MathTier T>
+OCEAN_TARGET_AVX2 inline __m256 fast_rsqrt_avx2(__m256 x)
+{
+    if (T == MATH_FAST || T == MATH_FASTEST)
+    {
+        __m256 y = _mm256_rsqrt_ps(x);
+        if (T == MATH_FAST)
+            y = _mm256_mul_ps(y, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), x), _mm256_mul_ps(y, y))));
+        return y;
+    }
+    return _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(x));
+}
+
+#endif
+
+#endif
@@ -0,0 +1,204 @@
+#include <math.h>
+#include <algorithm>
+#include <random>
+#include <unsupported/Eigen/FFT>
+#include "fast_math.h"
+#include "fft_ocean.h"
+
+// rows or columns handed to a job at a time
+#define FFT_GRAIN 8
+
+
+float fft_ocean_spectrum(const FftOceanParams &params, float kx, float kz)
+{
+    double k2 = (double)kx * kx + (double)kz * kz;
+    if (k2 == 0)
+        return 0;
+    double k = sqrt(k2);
+    double g = params.gravity;
+    double wl = sqrt((double)params.windX * params.windX + (double)params.windZ * params.windZ);
+    double wx = wl > 0 ? params.windX / wl : 1;
+    double wz = wl > 0 ? params.windZ / wl : 0;
+    double cosw = (kx * wx + kz * wz) / k;
+    double u = params.windSpeed;
+
+    if (params.spectrum == SPECTRUM_PHILLIPS)
+    {
+        // A exp(-1/(kL)^2) / k^4 |k.w|^2, with the waves much shorter than L damped away
+        double L = u * u / g;
+        double l = L / 1000;
+        return (float)(params.amplitude * exp(-1 / (k2 * L * L)) / (k2 * k2) * cosw * cosw * exp(-k2 * l * l));
+    }
+
+    // JONSWAP frequency spectrum with cos^2 spreading around the wind, carried over to
+    // wave vectors (dw/dk = g/2w, dkx dkz = k dk dtheta) and to the energy of one
+    // spectrum slot of size (2pi/length)^2, doubled to match the Phillips amplitude convention
+    if (cosw <= 0)
+        return 0;
+    double w = sqrt(g * k);
+    double alpha = 0.076 * pow(u * u / (params.fetch * g), 0.22);
+    double wp = 22 * pow(g * g / (u * params.fetch), 1.0 / 3.0);
+    double sigma = w <= wp ? 0.07 : 0.09;
+    double r = exp(-(w - wp) * (w - wp) / (2 * sigma * sigma * wp * wp));
+    double s = alpha * g * g / pow(w, 5) * exp(-1.25 * pow(wp / w, 4)) * pow((double)params.gamma, r);
+    double spread = 2 / FM_PI * cosw * cosw;
+    double dk = 2 * FM_PI / params.length;
+    return (float)(2 * s * spread * g / (2 * w) / k * dk * dk);
+}
+
+
+bool fft_ocean_matches(const FftOcean &ocean, const FftOceanParams &params)
+{
+    const FftOceanParams &p = ocean.params();
+    return p.n == params.n && p.length == params.length && p.windSpeed == params.windSpeed &&
+           p.windX == params.windX && p.windZ == params.windZ && p.amplitude == params.amplitude &&
+           p.fetch == params.fetch && p.gamma == params.gamma && p.gravity == params.gravity &&
+           p.choppiness == params.choppiness && p.seed == params.seed && p.spectrum == params.spectrum;
+}
+
+
+FftOcean::FftOcean(const FftOceanParams &params) : p(params)
+{
+    int n = p.n;
+    h0.assign(n * n, cfloat(0, 0));
+    h0mk.assign(n * n, cfloat(0, 0));
+    omega.assign(n * n, 0);
+    kx.assign(n * n, 0);
+    kz.assign(n * n, 0);
+
+    // slot b holds the wave number b, or b-n past the middle, so that the inverse
+    // transform is directly the sum over waves at the sample positions
+    std::mt19937 rng(p.seed);
+    std::normal_distribution<float> gauss(0, 1);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+        {
+            int mi = i < n / 2 ? i : i - n;
+            int mj = j < n / 2 ? j : j - n;
+            int s = i * n + j;
+            kx[s] = 2 * FM_PI * mi / p.length;
+            kz[s] = 2 * FM_PI * mj / p.length;
+            omega[s] = sqrt(p.gravity * sqrt(kx[s] * kx[s] + kz[s] * kz[s]));
+            float xr = gauss(rng);
+            float xi = gauss(rng);
+            // the Nyquist row and column have no negative partner and would break the real output
+            if (mi == -n / 2 || mj == -n / 2)
+                continue;
+            h0[s] = cfloat(xr, xi) * (float)sqrt(fft_ocean_spectrum(p, kx[s], kz[s]) / 2);
+        }
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            h0mk[i * n + j] = std::conj(h0[((n - i) % n) * n + (n - j) % n]);
+
+    for (int f = 0; f < 3; f++)
+        work[f].resize(n * n);
+}
+
+
+void FftOcean::inverse_2d(cfloat *data, JobSystem *jobs)
+{
+    int n = p.n;
+    parallel_for(jobs, 0, n, FFT_GRAIN, [&](int first, int last) {
+        Eigen::FFT<float> fft;
+        fft.SetFlag(Eigen::FFT<float>::Unscaled);
+        std::vector<cfloat> line(n);
+        for (int i = first; i < last; i++)
+        {
+            fft.inv(line.data(), &data[i * n], n);
+            std::copy(line.begin(), line.end(), &data[i * n]);
+        }
+    });
+    parallel_for(jobs, 0, n, FFT_GRAIN, [&](int first, int last) {
+        Eigen::FFT<float> fft;
+        fft.SetFlag(Eigen::FFT<float>::Unscaled);
+        std::vector<cfloat> column(n), line(n);
+        for (int j = first; j < last; j++)
+        {
+            for (int i = 0; i < n; i++)
+                column[i] = data[i * n + j];
+            fft.inv(line.data(), column.data(), n);
+            for (int i = 0; i < n; i++)
+                data[i * n + j] = line[i];
+        }
+    });
+}
+
+
+void FftOcean::evaluate(float t, float *height, float *disp_x, float *disp_z, float *slope_x, float *slope_z,
+                        JobSystem *jobs)
+{
+    int n = p.n;
+    bool need[3] = {height || disp_x, disp_z || slope_x, slope_z != NULL};
+    float chop = p.choppiness;
+
+    // the fields are real, so two of them share one complex transform:
+    // work[0] = h + i dx, work[1] = dz + i sx, work[2] = sz
+    parallel_for(jobs, 0, n, FFT_GRAIN, [&](int first, int last) {
+        const cfloat I(0, 1);
+        for (int s = first * n; s < last * n; s++)
+        {
+            float c = cos(omega[s] * t);
+            float sn = sin(omega[s] * t);
+            cfloat h = h0[s] * cfloat(c, sn) + h0mk[s] * cfloat(c, -sn);
+            float k = sqrt(kx[s] * kx[s] + kz[s] * kz[s]);
+            float ux = k > 0 ? kx[s] / k : 0;
+            float uz = k > 0 ? kz[s] / k : 0;
+            cfloat dx = -I * (chop * ux) * h;
+            cfloat dz = -I * (chop * uz) * h;
+            cfloat sx = I * kx[s] * h;
+            cfloat sz = I * kz[s] * h;
+            work[0][s] = h + I * dx;
+            work[1][s] = dz + I * sx;
+            work[2][s] = sz;
+        }
+    });
+
+    for (int f = 0; f < 3; f++)
+        if (need[f])
+            inverse_2d(work[f].data(), jobs);
+
+    parallel_for(jobs, 0, n, FFT_GRAIN, [&](int first, int last) {
+        for (int s = first * n; s < last * n; s++)
+        {
+            if (height)
+                height[s] = work[0][s].real();
+            if (disp_x)
+                disp_x[s] = work[0][s].imag();
+            if (disp_z)
+                disp_z[s] = work[1][s].real();
+            if (slope_x)
+                slope_x[s] = work[1][s].imag();
+            if (slope_z)
+                slope_z[s] = work[2][s].real();
+        }
+    });
+}
+
+
+void fft_ocean_sea_heights(const SeaGrid &g, const FftOceanParams &params, const float *tile_height, float level,
+                           float *heights, JobSystem *jobs)
+{
+    int n = params.n;
+    float scale = n / params.length;
+    parallel_for(jobs, -g.xfield, g.xfield + 2, FFT_GRAIN, [&](int first, int last) {
+        for (int xi = first; xi < last; xi++)
+        {
+            float u = xi * g.quadsize * scale;
+            u -= floor(u / n) * n;
+            int i0 = (int)u % n;
+            int i1 = (i0 + 1) % n;
+            float fu = u - floor(u);
+            for (int zi = -g.zfield; zi <= g.zfield + 1; zi++)
+            {
+                float v = zi * g.quadsize * scale;
+                v -= floor(v / n) * n;
+                int j0 = (int)v % n;
+                int j1 = (j0 + 1) % n;
+                float fv = v - floor(v);
+                float h0 = tile_height[i0 * n + j0] * (1 - fv) + tile_height[i0 * n + j1] * fv;
+                float h1 = tile_height[i1 * n + j0] * (1 - fv) + tile_height[i1 * n + j1] * fv;
+                heights[sea_index(g, xi, zi)] = level + h0 * (1 - fu) + h1 * fu;
+            }
+        }
+    });
+}
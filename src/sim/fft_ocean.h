@@ -0,0 +1,80 @@
+#ifndef _FFT_OCEAN_INC
+#define _FFT_OCEAN_INC
+
+#include <stddef.h>
+#include <complex>
+#include <vector>
+#include "sea.h"
+#include "jobs.h"
+
+// Spectral ocean after Tessendorf, "Simulating Ocean Water". A random
+// spectrum h0(k) is drawn once from a Phillips or JONSWAP energy spectrum;
+// every frame it is advanced with the deep water dispersion w(k) = sqrt(g|k|)
+// and the height, choppy displacement and slope fields of an n x n periodic
+// tile are rebuilt by inverse 2D FFTs (Eigen's unsupported FFT module). The
+// cost is O(n^2 log n) whatever the number of waves in the spectrum.
+// Tile fields are stored x-major like the sea arrays: sample (i,j) sits at
+// world (i*length/n, j*length/n) and lives in slot i*n + j.
+
+enum OceanSpectrum
+{
+    SPECTRUM_PHILLIPS = 0,
+    SPECTRUM_JONSWAP
+};
+
+struct FftOceanParams
+{
+    int n = 64;                 // tile resolution, a power of two
+    float length = 20.0f;       // world size of the tile
+    float windSpeed = 4.0f;     // world units per second, 10m above the sea
+    float windX = 1.0f;         // wind direction, normalized by the spectrum
+    float windZ = 0.6f;
+    float amplitude = 1e-4f;    // Phillips constant A
+    float fetch = 5000.0f;      // JONSWAP fetch, world units
+    float gamma = 3.3f;         // JONSWAP peak enhancement
+    float gravity = 9.81f;
+    float choppiness = 1.0f;    // scale of the horizontal displacement
+    unsigned int seed = 1;      // the same seed always gives the same sea
+    OceanSpectrum spectrum = SPECTRUM_PHILLIPS;
+};
+
+class FftOcean
+{
+public:
+    explicit FftOcean(const FftOceanParams &params);
+
+    const FftOceanParams &params() const { return p; }
+    int size() const { return p.n; }
+
+    // evaluates the tile at time t (seconds). Each output takes n*n floats and
+    // may be NULL when the field is not needed; disp_x/disp_z are already scaled
+    // by the choppiness. The 1D transforms of each pass are split over jobs by
+    // rows, then by columns.
+    void evaluate(float t, float *height, float *disp_x, float *disp_z, float *slope_x, float *slope_z,
+                  JobSystem *jobs = NULL);
+
+private:
+    typedef std::complex<float> cfloat;
+
+    void inverse_2d(cfloat *data, JobSystem *jobs);
+
+    FftOceanParams p;
+    std::vector<cfloat> h0;         // h0(k)
+    std::vector<cfloat> h0mk;       // conj(h0(-k))
+    std::vector<float> omega;       // w(k)
+    std::vector<float> kx, kz;      // wave vector of every spectrum slot
+    std::vector<cfloat> work[3];    // fields are transformed two at a time, as real + i*imaginary
+};
+
+// whether ocean was built from params, so that it need not be rebuilt
+bool fft_ocean_matches(const FftOcean &ocean, const FftOceanParams &params);
+
+// energy of the spectrum at wave vector (kx,kz), before the random draw
+float fft_ocean_spectrum(const FftOceanParams &params, float kx, float kz);
+
+// fills heights[sea_vertices] by sampling a tile height field over the sea
+// grid, repeating it past its edges, and adding level
+void fft_ocean_sea_heights(const SeaGrid &g, const FftOceanParams &params, const float *tile_height, float level,
+                           float *heights, JobSystem *jobs = NULL);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef _FRAME_STATS_INC
+#define _FRAME_STATS_INC
+
+#include <algorithm>
+
+// Rolling history of a per-frame timing: the last FRAME_STATS_HISTORY samples
+// in a ring, for graphs and for percentiles over the recent frames.
+
+#define FRAME_STATS_HISTORY 240
+
+struct FrameStats
+{
+    float samples[FRAME_STATS_HISTORY] = {};
+    int count = 0;      // samples held, up to FRAME_STATS_HISTORY
+    int next = 0;       // slot of the next sample, the oldest once the ring is full
+
+    void add(float ms)
+    {
+        samples[next] = ms;
+        next = (next + 1) % FRAME_STATS_HISTORY;
+        if (count < FRAME_STATS_HISTORY)
+            count++;
+    }
+
+    // sample at or below which a fraction q of the history lies, 0 without samples
+    float percentile(float q) const
+    {
+        if (count == 0)
+            return 0;
+        float sorted[FRAME_STATS_HISTORY];
+        std::copy(samples, samples + count, sorted);
+        int i = (int)(q * count + 0.999999f) - 1;
+        i = std::min(std::max(i, 0), count - 1);
+        std::nth_element(sorted, sorted + i, sorted + count);
+        return sorted[i];
+    }
+
+    // index of the oldest sample in samples, for plotting the history in order
+    int oldest() const { return count < FRAME_STATS_HISTORY ? 0 : next; }
+};
+
+#endif
@@ -0,0 +1,298 @@
+#include <math.h>
+#include <algorithm>
+#include <random>
+#include "fast_math.h"
+#include "gerstner.h"
+
+// columns handed to a job at a time
+#define GERSTNER_GRAIN 8
+
+
+void GerstnerWaves::clear()
+{
+    amplitude.clear();
+    dirx.clear();
+    dirz.clear();
+    wavenumber.clear();
+    frequency.clear();
+    phase.clear();
+    steepness.clear();
+}
+
+
+void GerstnerWaves::add(float amp, float dx, float dz, float wavelength, float steep, float ph, float gravity)
+{
+    float l = sqrtf(dx * dx + dz * dz);
+    float k = 2 * FM_PI / wavelength;
+    amplitude.push_back(amp);
+    dirx.push_back(l > 0 ? dx / l : 1);
+    dirz.push_back(l > 0 ? dz / l : 0);
+    wavenumber.push_back(k);
+    frequency.push_back(sqrtf(gravity * k));
+    phase.push_back(ph);
+    steepness.push_back(steep);
+}
+
+
+GerstnerWaves gerstner_wind_waves(int count, float wavelength, float amp, float windx, float windz, float steep,
+                                  unsigned int seed)
+{
+    GerstnerWaves w;
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0, 1);
+    float wind = atan2f(windz, windx);
+    for (int i = 0; i < count; i++)
+    {
+        float angle = wind + (unit(rng) * 2 - 1) * FM_PI / 3;
+        float l = wavelength * powf(2, unit(rng) * 2 - 1);
+        w.add(amp * l / wavelength, cosf(angle), sinf(angle), l, steep, unit(rng) * 2 * FM_PI);
+    }
+    return w;
+}
+
+
+// time part of every phase, w_i t reduced in double so the float phases stay
+// small however long the simulation runs
+static std::vector<float> time_phases(const GerstnerWaves &w, float t)
+{
+    std::vector<float> tp(w.count());
+    for (int i = 0; i < w.count(); i++)
+        tp[i] = (float)fmod((double)w.frequency[i] * t, 2 * FM_PI);
+    return tp;
+}
+
+
+static void gerstner_eval(const GerstnerWaves &w, const float *tp, float x, float z, float *height, float *normal,
+                          float *disp)
+{
+    int n = w.count();
+    float h = 0, nx = 0, ny = 0, nz = 0, dx = 0, dz = 0;
+    for (int i = 0; i < n; i++)
+    {
+        float k = w.wavenumber[i];
+        float th = k * (w.dirx[i] * x + w.dirz[i] * z) + w.phase[i] - tp[i];
+        float s = sinf(th);
+        float c = cosf(th);
+        float ka = k * w.amplitude[i];
+        float qa = w.steepness[i] / (k * n);
+        h += w.amplitude[i] * s;
+        nx += ka * w.dirx[i] * c;
+        nz += ka * w.dirz[i] * c;
+        ny += w.steepness[i] / n * s;
+        dx += qa * w.dirx[i] * c;
+        dz += qa * w.dirz[i] * c;
+    }
+    if (height)
+        *height = h;
+    if (normal)
+    {
+        // the upward normal is (-nx, 1-ny, -nz); the sea convention points down
+        normal[0] = nx;
+        normal[1] = ny - 1;
+        normal[2] = nz;
+    }
+    if (disp)
+    {
+        disp[0] = dx;
+        disp[1] = dz;
+    }
+}
+
+
+void gerstner_point(const GerstnerWaves &w, float x, float z, float t, float *height, float *normal, float *disp)
+{
+    std::vector<float> tp = time_phases(w, t);
+    gerstner_eval(w, tp.data(), x, z, height, normal, disp);
+}
+
+
+// Column kernels: vertex j of a column sits at (x, z0 + j*step). Every component
+// adds its terms to the six accumulators of all the vertices before the next
+// component is read, so the parameters are loaded once per column.
+struct GerstnerColumn
+{
+    float x, z0, step;     // position of vertex 0 and z spacing
+    int n;
+    float *h, *nx, *ny, *nz, *dx, *dz;
+};
+
+
+static void gerstner_column_scalar(const GerstnerWaves &w, const float *tp, const GerstnerColumn &col, int first)
+{
+    int count = w.count();
+    for (int i = 0; i < count; i++)
+    {
+        float k = w.wavenumber[i];
+        float base = k * (w.dirx[i] * col.x + w.dirz[i] * col.z0) + w.phase[i] - tp[i];
+        float step = k * w.dirz[i] * col.step;
+        float a = w.amplitude[i];
+        float kax = k * a * w.dirx[i], kaz = k * a * w.dirz[i];
+        float sy = w.steepness[i] / count;
+        float qax = w.steepness[i] / (k * count) * w.dirx[i], qaz = w.steepness[i] / (k * count) * w.dirz[i];
+        for (int j = first; j < col.n; j++)
+        {
+            float th = base + step * j;
+            float s = sinf(th);
+            float c = cosf(th);
+            col.h[j] += a * s;
+            col.nx[j] += kax * c;
+            col.nz[j] += kaz * c;
+            col.ny[j] += sy * s;
+            col.dx[j] += qax * c;
+            col.dz[j] += qaz * c;
+        }
+    }
+}
+
+
+#ifdef OCEAN_SIMD_X86
+
+// the phases of a tile stay within a few hundred radians, well inside the range
+// of the float reduction of MATH_FAST
+static void gerstner_column_sse2(const GerstnerWaves &w, const float *tp, const GerstnerColumn &col)
+{
+    int count = w.count();
+    int n4 = col.n & ~3;
+    const __m128 lane = _mm_set_ps(3, 2, 1, 0);
+    for (int i = 0; i < count; i++)
+    {
+        float k = w.wavenumber[i];
+        float step = k * w.dirz[i] * col.step;
+        __m128 base = _mm_set1_ps(k * (w.dirx[i] * col.x + w.dirz[i] * col.z0) + w.phase[i] - tp[i]);
+        __m128 vstep = _mm_set1_ps(step);
+        __m128 a = _mm_set1_ps(w.amplitude[i]);
+        __m128 kax = _mm_set1_ps(k * w.amplitude[i] * w.dirx[i]);
+        __m128 kaz = _mm_set1_ps(k * w.amplitude[i] * w.dirz[i]);
+        __m128 sy = _mm_set1_ps(w.steepness[i] / count);
+        __m128 qax = _mm_set1_ps(w.steepness[i] / (k * count) * w.dirx[i]);
+        __m128 qaz = _mm_set1_ps(w.steepness[i] / (k * count) * w.dirz[i]);
+        for (int j = 0; j < n4; j += 4)
+        {
+            __m128 th = _mm_add_ps(base, _mm_mul_ps(vstep, _mm_add_ps(_mm_set1_ps((float)j), lane)));
+            __m128 s, c;
+            fast_sincos_sse2<MATH_FAST>(th, &s, &c);
+            _mm_storeu_ps(col.h + j, _mm_add_ps(_mm_loadu_ps(col.h + j), _mm_mul_ps(a, s)));
+            _mm_storeu_ps(col.nx + j, _mm_add_ps(_mm_loadu_ps(col.nx + j), _mm_mul_ps(kax, c)));
+            _mm_storeu_ps(col.nz + j, _mm_add_ps(_mm_loadu_ps(col.nz + j), _mm_mul_ps(kaz, c)));
+            _mm_storeu_ps(col.ny + j, _mm_add_ps(_mm_loadu_ps(col.ny + j), _mm_mul_ps(sy, s)));
+            _mm_storeu_ps(col.dx + j, _mm_add_ps(_mm_loadu_ps(col.dx + j), _mm_mul_ps(qax, c)));
+            _mm_storeu_ps(col.dz + j, _mm_add_ps(_mm_loadu_ps(col.dz + j), _mm_mul_ps(qaz, c)));
+        }
+    }
+    gerstner_column_scalar(w, tp, col, n4);
+}
+
+
+OCEAN_TARGET_AVX2
+static void gerstner_column_avx2(const GerstnerWaves &w, const float *tp, const GerstnerColumn &col)
+{
+    int count = w.count();
+    int n8 = col.n & ~7;
+    const __m256 lane = _mm256_set_ps(7, 6, 5, 4, 3, 2, 1, 0);
+    for (int i = 0; i < count; i++)
+    {
+        float k = w.wavenumber[i];
+        float step = k * w.dirz[i] * col.step;
+        __m256 base = _mm256_set1_ps(k * (w.dirx[i] * col.x + w.dirz[i] * col.z0) + w.phase[i] - tp[i]);
+        __m256 vstep = _mm256_set1_ps(step);
+        __m256 a = _mm256_set1_ps(w.amplitude[i]);
+        __m256 kax = _mm256_set1_ps(k * w.amplitude[i] * w.dirx[i]);
+        __m256 kaz = _mm256_set1_ps(k * w.amplitude[i] * w.dirz[i]);
+        __m256 sy = _mm256_set1_ps(w.steepness[i] / count);
+        __m256 qax = _mm256_set1_ps(w.steepness[i] / (k * count) * w.dirx[i]);
+        __m256 qaz = _mm256_set1_ps(w.steepness[i] / (k * count) * w.dirz[i]);
+        for (int j = 0; j < n8; j += 8)
+        {
+            __m256 th = _mm256_add_ps(base, _mm256_mul_ps(vstep, _mm256_add_ps(_mm256_set1_ps((float)j), lane)));
+            __m256 s, c;
+            fast_sincos_avx2<MATH_FAST>(th, &s, &c);
+            _mm256_storeu_ps(col.h + j, _mm256_add_ps(_mm256_mul_ps(a, s), _mm256_loadu_ps(col.h + j)));
+            _mm256_storeu_ps(col.nx + j, _mm256_add_ps(_mm256_mul_ps(kax, c), _mm256_loadu_ps(col.nx + j)));
+            _mm256_storeu_ps(col.nz + j, _mm256_add_ps(_mm256_mul_ps(kaz, c), _mm256_loadu_ps(col.nz + j)));
+            _mm256_storeu_ps(col.ny + j, _mm256_add_ps(_mm256_mul_ps(sy, s), _mm256_loadu_ps(col.ny + j)));
+            _mm256_storeu_ps(col.dx + j, _mm256_add_ps(_mm256_mul_ps(qax, c), _mm256_loadu_ps(col.dx + j)));
+            _mm256_storeu_ps(col.dz + j, _mm256_add_ps(_mm256_mul_ps(qaz, c), _mm256_loadu_ps(col.dz + j)));
+        }
+    }
+    gerstner_column_scalar(w, tp, col, n8);
+}
+
+#endif
+
+
+static void gerstner_column(const GerstnerWaves &w, const float *tp, const GerstnerColumn &col)
+{
+#ifdef OCEAN_SIMD_X86
+    switch (simd_path())
+    {
+        case SIMD_AVX2: gerstner_column_avx2(w, tp, col); return;
+        case SIMD_SSE2: gerstner_column_sse2(w, tp, col); return;
+        default: break;
+    }
+#endif
+    gerstner_column_scalar(w, tp, col, 0);
+}
+
+
+void gerstner_sea(const SeaGrid &g, const GerstnerWaves &w, float t, float level, float *heights, float *normals,
+                  float *disp, JobSystem *jobs)
+{
+    std::vector<float> tp = time_phases(w, t);
+    int depth = sea_depth(g);
+    parallel_for(jobs, -g.xfield, g.xfield + 2, GERSTNER_GRAIN, [&](int first, int last) {
+        std::vector<float> acc(6 * depth);
+        for (int xi = first; xi < last; xi++)
+        {
+            std::fill(acc.begin(), acc.end(), 0.0f);
+            GerstnerColumn col;
+            col.x = xi * g.quadsize;
+            col.z0 = -g.zfield * g.quadsize;
+            col.step = g.quadsize;
+            col.n = depth;
+            col.h = &acc[0];
+            col.nx = &acc[depth];
+            col.ny = &acc[2 * depth];
+            col.nz = &acc[3 * depth];
+            col.dx = &acc[4 * depth];
+            col.dz = &acc[5 * depth];
+            gerstner_column(w, tp.data(), col);
+
+            int k0 = sea_index(g, xi, -g.zfield);
+            for (int j = 0; j < depth; j++)
+            {
+                heights[k0 + j] = level + col.h[j];
+                if (normals)
+                {
+                    normals[3 * (k0 + j)] = col.nx[j];
+                    normals[3 * (k0 + j) + 1] = col.ny[j] - 1;
+                    normals[3 * (k0 + j) + 2] = col.nz[j];
+                }
+                if (disp)
+                {
+                    disp[2 * (k0 + j)] = col.dx[j];
+                    disp[2 * (k0 + j) + 1] = col.dz[j];
+                }
+            }
+        }
+    });
+}
+
+
+float gerstner_sea_error(const SeaGrid &g, const GerstnerWaves &w, float t)
+{
+    std::vector<float> heights(sea_vertices(g)), normals(3 * sea_vertices(g));
+    gerstner_sea(g, w, t, 0, heights.data(), normals.data(), NULL);
+    std::vector<float> tp = time_phases(w, t);
+    float err = 0;
+    for (int xi = -g.xfield; xi <= g.xfield + 1; xi++)
+        for (int zi = -g.zfield; zi <= g.zfield + 1; zi++)
+        {
+            int k = sea_index(g, xi, zi);
+            float h, n[3];
+            gerstner_eval(w, tp.data(), xi * g.quadsize, zi * g.quadsize, &h, n, NULL);
+            err = fmaxf(err, fabsf(heights[k] - h));
+            for (int c = 0; c < 3; c++)
+                err = fmaxf(err, fabsf(normals[3 * k + c] - n[c]));
+        }
+    return err;
+}
@@ -0,0 +1,59 @@
+#ifndef _GERSTNER_INC
+#define _GERSTNER_INC
+
+#include <stddef.h>
+#include <vector>
+#include "sea.h"
+#include "jobs.h"
+
+// Gerstner (trochoidal) waves, after GPU Gems ch.1. Component i moves the
+// water above (x,z) on a circle:
+//   x += Q_i A_i Dx_i cos(th)   y += A_i sin(th)   z += Q_i A_i Dz_i cos(th)
+//   th = k_i (Dx_i x + Dz_i z) - w_i t + phase_i,   w_i = sqrt(g k_i)
+// with Q_i = steepness_i / (k_i A_i count), so crests sharpen as steepness goes
+// to 1 and never loop over. Unlike wave.h, positions are in world units and t
+// is in seconds. The components are kept as a structure of arrays so that the
+// grid kernels stream through every parameter contiguously.
+
+struct GerstnerWaves
+{
+    std::vector<float> amplitude;
+    std::vector<float> dirx, dirz;      // unit direction of travel
+    std::vector<float> wavenumber;      // k = 2pi / wavelength
+    std::vector<float> frequency;       // w, from the deep water dispersion
+    std::vector<float> phase;
+    std::vector<float> steepness;       // in [0,1], 0 gives plain sines
+
+    int count() const { return (int)amplitude.size(); }
+    void clear();
+    // direction (dx,dz) is normalized
+    void add(float amp, float dx, float dz, float wavelength, float steep, float ph = 0, float gravity = 9.81f);
+};
+
+// count components travelling within 60 degrees of the wind (windx,windz),
+// wavelengths spread over [wavelength/2, 2*wavelength] with amplitudes scaled
+// along (amp at wavelength), random phases drawn from seed
+GerstnerWaves gerstner_wind_waves(int count, float wavelength, float amp, float windx, float windz, float steep,
+                                  unsigned int seed = 1);
+
+// surface above world position (x,z): height above the rest level, the sea
+// normal in the sea_normals() convention (not normalized, pointing down) and
+// the horizontal displacement. Any output may be NULL.
+void gerstner_point(const GerstnerWaves &w, float x, float z, float t, float *height, float *normal, float *disp);
+
+// gerstner_point() over every vertex of the sea grid, as a drop-in for
+// sea_heights() + sea_normals(): heights[sea_vertices] get level added,
+// normals[3*sea_vertices] and disp[2*sea_vertices] may be NULL. Each column is
+// one pass over the components with the vertices of the column as the inner,
+// vector loop (AVX2, SSE2 or scalar as chosen by simd_path()).
+void gerstner_sea(const SeaGrid &g, const GerstnerWaves &w, float t, float level, float *heights, float *normals,
+                  float *disp, JobSystem *jobs = NULL);
+
+// largest height or normal difference between gerstner_sea() on the current
+// simd path and gerstner_point(), over the grid. The grid kernels step the
+// phases down each column and the vector paths use the MATH_FAST sincos; every
+// path stays within GERSTNER_SEA_TOLERANCE.
+#define GERSTNER_SEA_TOLERANCE 1e-5f
+float gerstner_sea_error(const SeaGrid &g, const GerstnerWaves &w, float t);
+
+#endif
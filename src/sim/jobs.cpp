@@ -0,0 +1,81 @@
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unsupported/Eigen/CXX11/ThreadPool>
+#include "jobs.h"
+#include "profiler.h"
+
+struct JobPool
+{
+    Eigen::NonBlockingThreadPool workers;
+    explicit JobPool(int n) : workers(n) {}
+};
+
+
+JobSystem::JobSystem(int threads)
+{
+    if (threads <= 0)
+        threads = (int)std::thread::hardware_concurrency();
+    nthreads = threads > 1 ? threads : 1;
+    // the calling thread works too, so the pool only needs the other threads
+    pool = nthreads > 1 ? new JobPool(nthreads - 1) : NULL;
+}
+
+
+JobSystem::~JobSystem()
+{
+    delete pool;
+}
+
+
+void JobSystem::parallel_for(int begin, int end, int grain, const std::function<void(int, int)> &f)
+{
+    if (end <= begin)
+        return;
+    if (grain < 1)
+        grain = 1;
+    int chunks = (end - begin + grain - 1) / grain;
+    if (!pool || chunks == 1 || pool->workers.CurrentThreadId() != -1)
+    {
+        f(begin, end);
+        return;
+    }
+
+    std::atomic<int> next(0);
+    auto run = [&]() {
+        // one event per thread taking part, so the trace shows how the range spread
+        OCEAN_PROFILE_SCOPE("parallel_for");
+        for (int c = next++; c < chunks; c = next++)
+        {
+            int first = begin + c * grain;
+            f(first, first + grain < end ? first + grain : end);
+        }
+    };
+
+    // helpers grab chunks until the range is exhausted; the caller waits for
+    // all of them since they reference this stack frame
+    int helpers = chunks - 1 < nthreads - 1 ? chunks - 1 : nthreads - 1;
+    int running = helpers;
+    std::mutex m;
+    std::condition_variable done;
+    for (int i = 0; i < helpers; i++)
+        pool->workers.Schedule([&]() {
+            run();
+            std::lock_guard<std::mutex> lock(m);
+            if (--running == 0)
+                done.notify_one();
+        });
+    run();
+    std::unique_lock<std::mutex> lock(m);
+    done.wait(lock, [&]() { return running == 0; });
+}
+
+
+void parallel_for(JobSystem *jobs, int begin, int end, int grain, const std::function<void(int, int)> &f)
+{
+    if (jobs)
+        jobs->parallel_for(begin, end, grain, f);
+    else if (end > begin)
+        f(begin, end);
+}
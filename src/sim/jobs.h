@@ -0,0 +1,39 @@
+#ifndef _JOBS_INC
+#define _JOBS_INC
+
+#include <stddef.h>
+#include <functional>
+
+// Job system for the data-parallel simulation stages, on top of Eigen's
+// work-stealing NonBlockingThreadPool. parallel_for() splits a range in
+// chunks; the pool workers and the calling thread take chunks until none is
+// left, and the call returns once every chunk has run. Chunks must write to
+// disjoint memory.
+
+struct JobPool;
+
+class JobSystem
+{
+public:
+    // threads counts the calling thread; 0 uses every hardware thread
+    explicit JobSystem(int threads = 0);
+    ~JobSystem();
+
+    int threads() const { return nthreads; }
+
+    // runs f(first, last) over [begin, end) in chunks of at most grain items.
+    // Nested calls from inside a chunk run serially on the calling thread.
+    void parallel_for(int begin, int end, int grain, const std::function<void(int, int)> &f);
+
+private:
+    JobSystem(const JobSystem &);
+    JobSystem &operator=(const JobSystem &);
+
+    int nthreads;
+    JobPool *pool;
+};
+
+// parallel_for on jobs, or a plain serial loop over the whole range when jobs is NULL
+void parallel_for(JobSystem *jobs, int begin, int end, int grain, const std::function<void(int, int)> &f);
+
+#endif
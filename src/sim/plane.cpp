@@ -3,7 +3,6 @@
 #pragma warning( disable : 4305 )  
 
 
-#include "point.h"
 #include "plane.h"
 
 
@@ -13,7 +12,7 @@ a=0;
 b=0;
 c=0;
 d=0;
-n.create(a,b,c);
+n=vec3d(a,b,c);
 }
 
 
@@ -23,8 +22,7 @@ a=pa;
 b=pb;
 c=pc;
 d=pd;
-n.create(a,b,c);
-n.normalize();
+n=normalize(vec3d(a,b,c));
 }
 
 
@@ -34,19 +32,13 @@ a=pa;
 b=pb;
 c=pc;
 d=pd;
-n.create(a,b,c);
-n.normalize();
+n=normalize(vec3d(a,b,c));
 }
 
 
-plane::plane(point p1,point p2,point p3)
+plane::plane(const vec3d &p1,const vec3d &p2,const vec3d &p3)
 {
-point p,q,r;
-
-p = p2 - p1;
-q = p3 - p1;
-r = p^q;
-r.normalize();
+vec3d r = normalize(cross(p2 - p1,p3 - p1));
 a = r.x;
 b = r.y;
 c = r.z;
@@ -57,7 +49,7 @@ d = - (a*p1.x+b*p1.y+c*p1.z);
 
 void plane::negate()
 {
-n.negate();
+n=-n;
 a=n.x;
 b=n.y;
 c=n.z;
@@ -65,14 +57,9 @@ d=-d;
 }
 
 
-void plane::create(point p1,point p2,point p3)
+void plane::create(const vec3d &p1,const vec3d &p2,const vec3d &p3)
 {
-point p,q,r;
-
-p = p2 - p1;
-q = p3 - p1;
-r = p^q;
-r.normalize();
+vec3d r = normalize(cross(p2 - p1,p3 - p1));
 a = r.x;
 b = r.y;
 c = r.z;
@@ -81,35 +68,7 @@ d = - (a*p1.x+b*p1.y+c*p1.z);
 }
 
 
-
-double plane::testline(point r,point vec,point &pres)
-// return value is distance along the line to the collision point
-{
-double fres;
-double t;
-fres=vec*n;
-pres=r;
-if ((fres)!=0)
-	{
-	t=-(n*r + d)/fres;
-	pres=r+vec*t;
-	}
-// hack... arreglar
-else t=0;
-return t;
-}
-
-
-double plane::testpoint(point p)
-{
-double res;
-
-res=p*n+d;
-return (res);
-}
-
-
-int plane::magicnumber(point p)
+int plane::magicnumber(const vec3d &p) const
 {
 float val;
 int valor;
@@ -121,28 +80,28 @@ return (valor);
 }
 
 
-double plane::evalxy(double x,double y)
+double plane::evalxy(double x,double y) const
 {
 if (c==0) return 0;
 else return -(a*x+b*y+d)/c;
 }
 
 
-double plane::evalxz(double x,double z)
+double plane::evalxz(double x,double z) const
 {
 if (b==0) return 0;
 else return -(a*x+c*z+d)/b;
 }
 
 
-double plane::evalyz(double y,double z)
+double plane::evalyz(double y,double z) const
 {
 if (a==0) return 0;
 else return -(b*y+c*z+d)/a;
 }
 
 
-int plane::testtri(point p1,point p2,point p3)
+int plane::testtri(const vec3d &p1,const vec3d &p2,const vec3d &p3) const
 {
 float valor1,valor2,valor3;
 int valor;
@@ -164,41 +123,24 @@ return(valor);
 }
 
 
-point plane::getpointfromplane()
+vec3d plane::getpointfromplane() const
 // gives us a random point on the surface of the plane
 {
-point res;
+vec3d res;
 
 if (a!=0)
 	{
-	res.create(-d/a,0,0);
+	res=vec3d(-d/a,0,0);
 	return res;
 	}
 if (b!=0)
 	{
-	res.create(0,-d/a,0);
+	res=vec3d(0,-d/a,0);
 	return res;
 	}
 if (c!=0)
 	{
-	res.create(0,0,-d/a);
+	res=vec3d(0,0,-d/a);
 	}
 return res;
 }
-
-
-void plane::operator=(plane p)
-{
-a=p.a;
-b=p.b;
-c=p.c;
-d=p.d;
-n=p.n;
-}
-
-
-plane::~plane()
-{
-
-
-}
\ No newline at end of file
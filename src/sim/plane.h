@@ -0,0 +1,60 @@
+#ifndef _PLANE_INC
+#define _PLANE_INC
+
+#include "vec3.h"
+
+
+class plane
+{
+public:
+	
+	float a,b,c,d;
+	vec3d n;
+
+	plane();
+
+	// constructors from a,b,c,d
+	plane(float,float,float,float);
+	void create(float,float,float,float);
+
+	// constructors from 3 passing points
+	plane(const vec3d &,const vec3d &,const vec3d &);
+	void create(const vec3d &,const vec3d &,const vec3d &);
+	void negate();
+
+	// point comes in xyz. The result indicates the distance
+	// to the plane's oriented surface from the point. Values
+	// >0 mean point outside (in the normal side) of the plane.
+	// <0 mean inside, and =0 mean point on surface.
+	double testpoint(const vec3d &p) const { return dot(p,n)+d; }
+	
+
+	// line comes in the form of passing point + director vector. 
+	// result is 0 if line parallel to plane. !0 if colliding,
+	// and then the third param returns the interesction point.
+	// Inline and in the precision of the line, so the per vertex
+	// caustic loops can stay in float.
+	template <typename T>
+	T testline(const vec3<T> &r,const vec3<T> &vec,vec3<T> &pres) const
+	{
+		vec3<T> nt(n);
+		T fres=dot(vec,nt);
+		pres=r;
+		if (fres==0) return 0;
+		T t=-(dot(nt,r)+(T)d)/fres;
+		pres=r+vec*t;
+		return t;
+	}
+
+	
+	int magicnumber(const vec3d &) const;
+	int testtri(const vec3d &,const vec3d &,const vec3d &) const;
+	
+	vec3d getpointfromplane() const;
+
+	double evalxy(double,double) const;
+	double evalxz(double,double) const;
+	double evalyz(double,double) const;
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include "profiler.h"
+
+// the events of one thread. Only that thread writes them; head counts every
+// event it ever recorded and is published after the event itself, so a reader
+// sees complete events up to head. Rings outlive their threads, so the events
+// of finished threads still end up in the trace.
+struct ProfileRing
+{
+    ProfileEvent events[PROFILER_RING_EVENTS];
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> floor;        // head at the last profiler_clear()
+    std::atomic<const char *> name;
+    int tid;
+};
+
+static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+static std::atomic<bool> enabled(false);
+static std::mutex ringsLock;
+static std::vector<ProfileRing *> rings;
+static thread_local ProfileRing *threadRing = NULL;
+
+
+// the calling thread's ring, registered on its first event
+static ProfileRing *thread_ring()
+{
+    if (!threadRing)
+    {
+        ProfileRing *r = new ProfileRing();
+        r->head = 0;
+        r->floor = 0;
+        r->name = NULL;
+        std::lock_guard<std::mutex> lock(ringsLock);
+        r->tid = (int)rings.size() + 1;
+        rings.push_back(r);
+        threadRing = r;
+    }
+    return threadRing;
+}
+
+
+int64_t profiler_now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+
+void profiler_enable(bool on)
+{
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+
+bool profiler_enabled()
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+
+void profiler_record(const char *name, int64_t start_ns, int64_t duration_ns)
+{
+    ProfileRing *r = thread_ring();
+    uint64_t h = r->head.load(std::memory_order_relaxed);
+    ProfileEvent &e = r->events[h & (PROFILER_RING_EVENTS - 1)];
+    e.name = name;
+    e.start_ns = start_ns;
+    e.duration_ns = duration_ns;
+    r->head.store(h + 1, std::memory_order_release);
+}
+
+
+void profiler_thread_name(const char *name)
+{
+    thread_ring()->name.store(name, std::memory_order_relaxed);
+}
+
+
+void profiler_clear()
+{
+    std::lock_guard<std::mutex> lock(ringsLock);
+    for (ProfileRing *r : rings)
+        r->floor.store(r->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+
+// names are identifiers in practice; quotes and backslashes are all JSON needs escaped
+static void write_name(FILE *f, const char *name)
+{
+    fputc('"', f);
+    for (const char *c = name; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            fputc('\\', f);
+        fputc(*c, f);
+    }
+    fputc('"', f);
+}
+
+
+bool profiler_write_trace(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+        return false;
+    std::vector<ProfileRing *> all;
+    {
+        std::lock_guard<std::mutex> lock(ringsLock);
+        all = rings;
+    }
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first = true;
+    std::vector<ProfileEvent> copy;
+    for (ProfileRing *r : all)
+    {
+        const char *name = r->name.load(std::memory_order_relaxed);
+        fprintf(f, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": ",
+                first ? "" : ",\n", r->tid);
+        if (name)
+            write_name(f, name);
+        else
+            fprintf(f, "\"thread %d\"", r->tid);
+        fprintf(f, "}}");
+        first = false;
+
+        // copy the ring, then drop what the thread may have overwritten meanwhile:
+        // everything older than the ring's length before its head after the copy
+        uint64_t head = r->head.load(std::memory_order_acquire);
+        uint64_t begin = r->floor.load(std::memory_order_relaxed);
+        if (head - begin > PROFILER_RING_EVENTS)
+            begin = head - PROFILER_RING_EVENTS;
+        copy.clear();
+        for (uint64_t i = begin; i < head; i++)
+            copy.push_back(r->events[i & (PROFILER_RING_EVENTS - 1)]);
+        uint64_t after = r->head.load(std::memory_order_acquire);
+        uint64_t valid = after >= PROFILER_RING_EVENTS ? after - PROFILER_RING_EVENTS + 1 : 0;
+        for (uint64_t i = begin > valid ? begin : valid; i < head; i++)
+        {
+            const ProfileEvent &e = copy[i - begin];
+            fprintf(f, ",\n{\"name\": ");
+            write_name(f, e.name);
+            fprintf(f, ", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}", r->tid,
+                    e.start_ns / 1000.0, e.duration_ns / 1000.0);
+        }
+    }
+    fprintf(f, "\n]}\n");
+    return fclose(f) == 0;
+}
@@ -0,0 +1,158 @@
+#include <math.h>
+#include "ray_plane.h"
+
+#ifdef OCEAN_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#define PARALLEL_SQ (RAY_PLANE_PARALLEL * RAY_PLANE_PARALLEL)
+
+
+// the plane in the precision of the rays: unit normal n and offset d, n.x + d = 0
+struct PlaneF
+{
+    float nx, ny, nz, d;
+};
+
+
+static PlaneF plane_f(const plane &pl)
+{
+    vec3f n(pl.n);
+    PlaneF p = {n.x, n.y, n.z, pl.d};
+    return p;
+}
+
+
+// t of the hit of ray i, in the operation order of plane::testline()
+static inline float ray_t(const PlaneF &p, const RayArrays &r, int i, int *parallel)
+{
+    float f = r.dx[i] * p.nx + r.dy[i] * p.ny + r.dz[i] * p.nz;
+    float num = -(p.nx * r.ox[i] + p.ny * r.oy[i] + p.nz * r.oz[i] + p.d);
+    float len2 = r.dx[i] * r.dx[i] + r.dy[i] * r.dy[i] + r.dz[i] * r.dz[i];
+    if (f * f <= PARALLEL_SQ * len2)
+    {
+        (*parallel)++;
+        return 0;
+    }
+    return num / f;
+}
+
+
+static int uvs_scalar(const RayArrays &r, const PlaneF *p, int count, float scale, float *const *uvs, int i)
+{
+    int parallel = 0;
+    for (; i < r.n; i++)
+        for (int k = 0; k < count; k++)
+        {
+            float ti = ray_t(p[k], r, i, &parallel);
+            uvs[k][2 * i] = (r.ox[i] + r.dx[i] * ti) * scale;
+            uvs[k][2 * i + 1] = (r.oz[i] + r.dz[i] * ti) * scale;
+        }
+    return parallel;
+}
+
+
+#ifdef OCEAN_SIMD_X86
+
+// set bits of every 4 bit movemask, as a portable popcount
+static const int maskBits[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+// t of the hits of rays i..i+3; parallel lanes get t = 0 and are counted
+static inline __m128 ray_t_sse2(const PlaneF &p, const RayArrays &r, int i, int *parallel)
+{
+    __m128 dx = _mm_loadu_ps(r.dx + i), dy = _mm_loadu_ps(r.dy + i), dz = _mm_loadu_ps(r.dz + i);
+    __m128 nx = _mm_set1_ps(p.nx), ny = _mm_set1_ps(p.ny), nz = _mm_set1_ps(p.nz);
+    __m128 f = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, nx), _mm_mul_ps(dy, ny)), _mm_mul_ps(dz, nz));
+    __m128 num = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, _mm_loadu_ps(r.ox + i)), _mm_mul_ps(ny, _mm_loadu_ps(r.oy + i))),
+                            _mm_mul_ps(nz, _mm_loadu_ps(r.oz + i)));
+    num = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(num, _mm_set1_ps(p.d)));
+    __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+    __m128 par = _mm_cmple_ps(_mm_mul_ps(f, f), _mm_mul_ps(_mm_set1_ps(PARALLEL_SQ), len2));
+    *parallel += maskBits[_mm_movemask_ps(par)];
+    return _mm_andnot_ps(par, _mm_div_ps(num, f));
+}
+
+
+static int uvs_sse2(const RayArrays &r, const PlaneF *p, int count, float scale, float *const *uvs)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    int parallel = 0;
+    int i = 0;
+    for (; i + 4 <= r.n; i += 4)
+        for (int k = 0; k < count; k++)
+        {
+            __m128 ti = ray_t_sse2(p[k], r, i, &parallel);
+            __m128 u = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(r.ox + i), _mm_mul_ps(_mm_loadu_ps(r.dx + i), ti)), s);
+            __m128 v = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(r.oz + i), _mm_mul_ps(_mm_loadu_ps(r.dz + i), ti)), s);
+            // interleave to u0 v0 u1 v1 | u2 v2 u3 v3
+            _mm_storeu_ps(uvs[k] + 2 * i, _mm_unpacklo_ps(u, v));
+            _mm_storeu_ps(uvs[k] + 2 * i + 4, _mm_unpackhi_ps(u, v));
+        }
+    return parallel + uvs_scalar(r, p, count, scale, uvs, i);
+}
+
+
+OCEAN_TARGET_AVX2
+static inline __m256 ray_t_avx2(const PlaneF &p, const RayArrays &r, int i, int *parallel)
+{
+    __m256 dx = _mm256_loadu_ps(r.dx + i), dy = _mm256_loadu_ps(r.dy + i), dz = _mm256_loadu_ps(r.dz + i);
+    __m256 nx = _mm256_set1_ps(p.nx), ny = _mm256_set1_ps(p.ny), nz = _mm256_set1_ps(p.nz);
+    __m256 f = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, nx), _mm256_mul_ps(dy, ny)), _mm256_mul_ps(dz, nz));
+    __m256 num = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, _mm256_loadu_ps(r.ox + i)),
+                                             _mm256_mul_ps(ny, _mm256_loadu_ps(r.oy + i))),
+                               _mm256_mul_ps(nz, _mm256_loadu_ps(r.oz + i)));
+    num = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_add_ps(num, _mm256_set1_ps(p.d)));
+    __m256 len2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+    __m256 par = _mm256_cmp_ps(_mm256_mul_ps(f, f), _mm256_mul_ps(_mm256_set1_ps(PARALLEL_SQ), len2), _CMP_LE_OQ);
+    int mask = _mm256_movemask_ps(par);
+    *parallel += maskBits[mask & 15] + maskBits[mask >> 4];
+    return _mm256_andnot_ps(par, _mm256_div_ps(num, f));
+}
+
+
+OCEAN_TARGET_AVX2
+static int uvs_avx2(const RayArrays &r, const PlaneF *p, int count, float scale, float *const *uvs)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    int parallel = 0;
+    int i = 0;
+    for (; i + 8 <= r.n; i += 8)
+        for (int k = 0; k < count; k++)
+        {
+            __m256 ti = ray_t_avx2(p[k], r, i, &parallel);
+            __m256 u = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(r.ox + i), _mm256_mul_ps(_mm256_loadu_ps(r.dx + i), ti)), s);
+            __m256 v = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(r.oz + i), _mm256_mul_ps(_mm256_loadu_ps(r.dz + i), ti)), s);
+            // unpack interleaves within each 128 bit half: u0 v0 u1 v1 u4 v4 u5 v5 and u2 v2 u3 v3 u6 v6 u7 v7
+            __m256 lo = _mm256_unpacklo_ps(u, v);
+            __m256 hi = _mm256_unpackhi_ps(u, v);
+            _mm256_storeu_ps(uvs[k] + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+            _mm256_storeu_ps(uvs[k] + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+        }
+    return parallel + uvs_scalar(r, p, count, scale, uvs, i);
+}
+
+#endif
+
+
+int ray_planes_uvs(const RayArrays &r, const plane *planes, int count, float scale, float *const *uvs)
+{
+    // the planes are converted once per batch, not once per ray
+    PlaneF p[8];
+    int parallel = 0;
+    for (int first = 0; first < count; first += 8)
+    {
+        int m = count - first < 8 ? count - first : 8;
+        for (int k = 0; k < m; k++)
+            p[k] = plane_f(planes[first + k]);
+#ifdef OCEAN_SIMD_X86
+        switch (simd_path())
+        {
+            case SIMD_AVX2: parallel += uvs_avx2(r, p, m, scale, uvs + first); continue;
+            case SIMD_SSE2: parallel += uvs_sse2(r, p, m, scale, uvs + first); continue;
+            default: break;
+        }
+#endif
+        parallel += uvs_scalar(r, p, m, scale, uvs + first, 0);
+    }
+    return parallel;
+}
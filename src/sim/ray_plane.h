@@ -0,0 +1,31 @@
+#ifndef _RAY_PLANE_INC
+#define _RAY_PLANE_INC
+
+#include "plane.h"
+#include "simd.h"
+
+// Batch intersection of rays o + t*d with planes, 8 rays at a time with AVX2, 4
+// with SSE2 or one by one, as chosen by simd_path(). Rays come as a structure
+// of arrays; the directions need not be normalized. The arithmetic is that of
+// plane::testline() in float, so every path gives the same hits.
+//
+// A ray is parallel to a plane when the cosine between its direction and the
+// plane normal is at most RAY_PLANE_PARALLEL: it never reaches the plane (or
+// only at a distance where float hits are noise), so its hit is reported as
+// its own origin with t = 0, as testline() does for exactly parallel lines.
+
+#define RAY_PLANE_PARALLEL 1e-6f
+
+struct RayArrays
+{
+    const float *ox, *oy, *oz;      // origins
+    const float *dx, *dy, *dz;      // directions
+    int n;
+};
+
+// lightmap coordinates of the hits with each of count planes, scaled by scale:
+// uvs[p][2*i] = hit.x*scale and uvs[p][2*i+1] = hit.z*scale for plane p.
+// Returns the number of parallel rays over all planes.
+int ray_planes_uvs(const RayArrays &r, const plane *planes, int count, float scale, float *const *uvs);
+
+#endif
@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "sea.h"
+#include "ray_plane.h"
+#include "wave_batch.h"
+
+// columns handed to a job at a time
+#define SEA_GRAIN 8
+
+
+bool sea_grid_valid(const SeaGrid &g)
+{
+    return g.xfield >= 1 && g.xfield <= SEA_MAX_FIELD && g.zfield >= 1 && g.zfield <= SEA_MAX_FIELD &&
+           g.quadsize > 0 && g.texdivider > 0;
+}
+
+
+bool sea_grid_set(SeaGrid &g, const char *key, const char *value)
+{
+    char *end;
+    double v = strtod(value, &end);
+    if (end == value || *end != 0)
+        return false;
+    if (strcmp(key, "field") == 0)
+        g.xfield = g.zfield = (int)v;
+    else if (strcmp(key, "xfield") == 0)
+        g.xfield = (int)v;
+    else if (strcmp(key, "zfield") == 0)
+        g.zfield = (int)v;
+    else if (strcmp(key, "quadsize") == 0)
+        g.quadsize = (float)v;
+    else if (strcmp(key, "texdivider") == 0)
+        g.texdivider = (float)v;
+    else
+        return false;
+    return true;
+}
+
+
+// splits "key = value" around the '=' and drops the blanks around both
+static bool sea_grid_setting(SeaGrid &g, std::string s)
+{
+    size_t eq = s.find('=');
+    if (eq == std::string::npos)
+        return false;
+    std::string key = s.substr(0, eq), value = s.substr(eq + 1);
+    for (std::string *t : {&key, &value})
+    {
+        size_t b = t->find_first_not_of(" \t\r\n");
+        size_t e = t->find_last_not_of(" \t\r\n");
+        *t = b == std::string::npos ? std::string() : t->substr(b, e - b + 1);
+    }
+    return sea_grid_set(g, key.c_str(), value.c_str());
+}
+
+
+bool sea_grid_parse(SeaGrid &g, const char *settings)
+{
+    std::string s(settings);
+    size_t begin = 0;
+    while (begin <= s.size())
+    {
+        size_t end = s.find(',', begin);
+        if (end == std::string::npos)
+            end = s.size();
+        if (!sea_grid_setting(g, s.substr(begin, end - begin)))
+            return false;
+        begin = end + 1;
+    }
+    return true;
+}
+
+
+bool sea_grid_load(SeaGrid &g, const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+    char line[256];
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), f))
+    {
+        char *hash = strchr(line, '#');
+        if (hash)
+            *hash = 0;
+        const char *p = line;
+        while (isspace((unsigned char)*p))
+            p++;
+        if (*p)
+            ok = sea_grid_setting(g, p);
+    }
+    fclose(f);
+    return ok;
+}
+
+
+// maps (xi,zi) to its mirror image (*a,*b) in the fundamental region; *swap and
+// *neg tell which of the two symmetries took it there
+static void sea_fundamental(int xi, int zi, int *a, int *b, bool *swap, bool *neg)
+{
+    int ax = xi < 0 ? -xi : xi;
+    int az = zi < 0 ? -zi : zi;
+    if (xi >= az)       { *a = xi;  *b = zi;  *swap = false; *neg = false; }
+    else if (zi >= ax)  { *a = zi;  *b = xi;  *swap = true;  *neg = false; }
+    else if (-xi >= az) { *a = -xi; *b = -zi; *swap = false; *neg = true; }
+    else                { *a = -zi; *b = -xi; *swap = true;  *neg = true; }
+}
+
+
+void sea_mirror(const SeaGrid &g, float *values, JobSystem *jobs)
+{
+    parallel_for(jobs, -g.xfield, g.xfield + 2, SEA_GRAIN, [&](int first, int last) {
+        for (int xi = first; xi < last; xi++)
+            for (int zi = -g.zfield; zi <= g.zfield + 1; zi++)
+            {
+                int a, b;
+                bool swap, neg;
+                sea_fundamental(xi, zi, &a, &b, &swap, &neg);
+                if (swap || neg)
+                    values[sea_index(g, xi, zi)] = values[sea_index(g, a, b)];
+            }
+    });
+}
+
+
+void sea_mirror_normals(const SeaGrid &g, float *normals, JobSystem *jobs)
+{
+    parallel_for(jobs, -g.xfield, g.xfield + 2, SEA_GRAIN, [&](int first, int last) {
+        for (int xi = first; xi < last; xi++)
+            for (int zi = -g.zfield; zi <= g.zfield + 1; zi++)
+            {
+                int a, b;
+                bool swap, neg;
+                sea_fundamental(xi, zi, &a, &b, &swap, &neg);
+                if (!swap && !neg)
+                    continue;
+                const float *m = &normals[3 * sea_index(g, a, b)];
+                float *n = &normals[3 * sea_index(g, xi, zi)];
+                float sign = neg ? -1.0f : 1.0f;
+                n[0] = sign * (swap ? m[2] : m[0]);
+                n[1] = m[1];
+                n[2] = sign * (swap ? m[0] : m[2]);
+            }
+    });
+}
+
+
+void sea_heights(const SeaGrid &g, const WaveParams &w, float timer, float *heights, JobSystem *jobs)
+{
+    // one batch per column: x is constant and z runs over the contiguous slots of the column
+    bool symmetric = sea_symmetric(g);
+    int depth = sea_depth(g);
+    parallel_for(jobs, symmetric ? 0 : -g.xfield, g.xfield + 2, SEA_GRAIN, [&](int first, int last) {
+        std::vector<float> x(depth), z(depth);
+        for (int xi = first; xi < last; xi++)
+        {
+            int z0 = -g.zfield, z1 = g.zfield + 1;
+            if (symmetric)
+                sea_fundamental_range(g, xi, &z0, &z1);
+            for (int k = 0; k <= z1 - z0; k++)
+            {
+                x[k] = xi;
+                z[k] = z0 + k;
+            }
+            wave_height_batch(w, x.data(), z.data(), z1 - z0 + 1, timer, &heights[sea_index(g, xi, z0)]);
+        }
+    });
+    if (symmetric)
+        sea_mirror(g, heights, jobs);
+}
+
+
+void sea_normals(const SeaGrid &g, const float *heights, float *normals, JobSystem *jobs)
+{
+    // the last row and column have no forward neighbour and reuse the previous normal
+    parallel_for(jobs, -g.xfield, g.xfield + 2, SEA_GRAIN, [&](int first, int last) {
+        for (int xi = first; xi < last; xi++)
+            for (int zi = -g.zfield; zi <= g.zfield + 1; zi++)
+            {
+                int x = xi <= g.xfield ? xi : g.xfield;
+                int z = zi <= g.zfield ? zi : g.zfield;
+                float h = heights[sea_index(g, x, z)];
+                vec3f e1(g.quadsize, heights[sea_index(g, x + 1, z)] - h, 0);
+                vec3f e2(0, heights[sea_index(g, x, z + 1)] - h, g.quadsize);
+                vec3_store(&normals[3 * sea_index(g, xi, zi)], cross(e1, e2));
+            }
+    });
+}
+
+
+void sea_heights_normals(const SeaGrid &g, const WaveParams &w, float timer, float *heights, float *normals,
+                         JobSystem *jobs)
+{
+    // e1 = (quadsize, dh/dx, 0) and e2 = (0, dh/dz, quadsize), with the derivatives per grid index
+    bool symmetric = sea_symmetric(g);
+    float q = g.quadsize;
+    parallel_for(jobs, symmetric ? 0 : -g.xfield, g.xfield + 2, SEA_GRAIN, [&](int first, int last) {
+        for (int xi = first; xi < last; xi++)
+        {
+            int z0 = -g.zfield, z1 = g.zfield + 1;
+            if (symmetric)
+                sea_fundamental_range(g, xi, &z0, &z1);
+            for (int zi = z0; zi <= z1; zi++)
+            {
+                int k = sea_index(g, xi, zi);
+                float gx, gz;
+                heights[k] = wave_height_grad(w, xi, zi, timer, &gx, &gz);
+                normals[3 * k] = q * gx;
+                normals[3 * k + 1] = -q * q;
+                normals[3 * k + 2] = q * gz;
+            }
+        }
+    });
+    if (symmetric)
+    {
+        sea_mirror(g, heights, jobs);
+        sea_mirror_normals(g, normals, jobs);
+    }
+}
+
+
+void sea_caustic_uvs_planes(const SeaGrid &g, const float *heights, const float *normals, const plane *planes,
+                            int count, float *const *uvs, JobSystem *jobs)
+{
+    // one batch of rays per column: the origins' x is constant, their y is the
+    // contiguous column of heights and z is the same for every column
+    int depth = sea_depth(g);
+    parallel_for(jobs, -g.xfield, g.xfield + 2, SEA_GRAIN, [&](int first, int last) {
+        std::vector<float> ox(depth), oz(depth), dx(depth), dy(depth), dz(depth);
+        std::vector<float *> out(count);
+        for (int k = 0; k < depth; k++)
+            oz[k] = (k - g.zfield) * g.quadsize;
+        for (int xi = first; xi < last; xi++)
+        {
+            int base = sea_index(g, xi, -g.zfield);
+            std::fill(ox.begin(), ox.end(), xi * g.quadsize);
+            vec3_soa_split(&normals[3 * base], depth, dx.data(), dy.data(), dz.data());
+            RayArrays r = {ox.data(), &heights[base], oz.data(), dx.data(), dy.data(), dz.data(), depth};
+            for (int p = 0; p < count; p++)
+                out[p] = &uvs[p][2 * base];
+            ray_planes_uvs(r, planes, count, 1 / g.texdivider, out.data());
+        }
+    });
+}
+
+
+void sea_caustic_uvs(const SeaGrid &g, const float *heights, const float *normals, const plane &pl, float *uvs,
+                     JobSystem *jobs)
+{
+    sea_caustic_uvs_planes(g, heights, normals, &pl, 1, &uvs, jobs);
+}
+
+
+void sea_mesh_indices(const SeaGrid &g, unsigned int *indices)
+{
+    int rows = sea_mesh_rows(g);
+    for (int c = 0; c < sea_mesh_columns(g) - 1; c++)
+        for (int r = 0; r < rows - 1; r++)
+        {
+            // the two triangles of the quad, in triangle strip order
+            unsigned int a = c * rows + r;
+            unsigned int b = a + rows;
+            indices[0] = a;
+            indices[1] = b;
+            indices[2] = a + 1;
+            indices[3] = a + 1;
+            indices[4] = b;
+            indices[5] = b + 1;
+            indices += 6;
+        }
+}
+
+
+void sea_mesh(const SeaGrid &g, const float *heights, const float *disp, float floor_y, const float *uvs, float *out,
+              JobSystem *jobs)
+{
+    int rows = sea_mesh_rows(g);
+    parallel_for(jobs, -g.xfield, g.xfield + 1, SEA_GRAIN, [&](int first, int last) {
+        for (int xi = first; xi < last; xi++)
+        {
+            float *v = out + 5 * (xi + g.xfield) * rows;
+            for (int zi = -g.zfield; zi < g.zfield; zi++)
+            {
+                int k = sea_index(g, xi, zi);
+                v[0] = xi * g.quadsize;
+                v[1] = heights ? heights[k] : floor_y;
+                v[2] = zi * g.quadsize;
+                if (disp)
+                {
+                    v[0] += disp[2 * k];
+                    v[2] += disp[2 * k + 1];
+                }
+                v[3] = uvs[2 * k];
+                v[4] = uvs[2 * k + 1];
+                v += 5;
+            }
+        }
+    });
+}
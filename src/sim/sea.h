@@ -0,0 +1,119 @@
+#ifndef _SEA_INC
+#define _SEA_INC
+
+#include <stddef.h>
+#include "wave.h"
+#include "plane.h"
+#include "jobs.h"
+
+// The sea is a grid of vertices (xi,zi), xi in [-xfield, xfield+1] and
+// zi in [-zfield, zfield+1], placed at (xi*quadsize, height, zi*quadsize).
+// All per-vertex arrays are stored x-major: sea_index() gives the slot of a
+// vertex, heights take one float per slot, normals three and uvs two.
+// Every function writes into buffers owned by the caller and none of them
+// touches OpenGL, so they can run on hosts without a display. Stages taking a
+// JobSystem split the grid by columns over its threads; NULL runs them serially.
+
+struct SeaGrid
+{
+    int xfield = 50;
+    int zfield = 50;
+    float quadsize = 0.4f;      // world size of one grid quad
+    float texdivider = 40;      // world size covered by one lightmap repeat
+};
+
+// largest xfield and zfield; every vertex and mesh index then fits an int
+#define SEA_MAX_FIELD 4096
+
+// true when xfield and zfield are in [1, SEA_MAX_FIELD] and both sizes are positive
+bool sea_grid_valid(const SeaGrid &g);
+
+// sets one parameter by name: xfield, zfield, field (both of them), quadsize or
+// texdivider. False for an unknown name or a value that is not a number.
+bool sea_grid_set(SeaGrid &g, const char *key, const char *value);
+
+// applies comma separated key=value settings, e.g. "field=200,quadsize=0.1"
+bool sea_grid_parse(SeaGrid &g, const char *settings);
+
+// applies a configuration file of "key = value" lines, # starting a comment;
+// false if it cannot be read or sets something sea_grid_set() rejects
+bool sea_grid_load(SeaGrid &g, const char *path);
+
+inline int sea_width(const SeaGrid &g) { return 2 * g.xfield + 2; }
+inline int sea_depth(const SeaGrid &g) { return 2 * g.zfield + 2; }
+inline int sea_vertices(const SeaGrid &g) { return sea_width(g) * sea_depth(g); }
+
+inline int sea_index(const SeaGrid &g, int xi, int zi)
+{
+    return (xi + g.xfield) * sea_depth(g) + (zi + g.zfield);
+}
+
+// Symmetry of the trig wave model: wave_height() only sees x*z and x*x+z*z, so
+// it is unchanged by swapping x and z and by negating both. On a square grid
+// every vertex then mirrors one of the fundamental region xi >= |zi|, about a
+// quarter of the grid, and the trig stages below only evaluate that region.
+// Other wave models (fft_ocean.h, gerstner.h) have no such symmetry and never
+// go through these helpers.
+inline bool sea_symmetric(const SeaGrid &g) { return g.xfield == g.zfield; }
+
+// zi range [*z0, *z1] of column xi inside the fundamental region, empty (*z1 < *z0) for xi < 0
+inline void sea_fundamental_range(const SeaGrid &g, int xi, int *z0, int *z1)
+{
+    *z0 = -xi > -g.zfield ? -xi : -g.zfield;
+    *z1 = xi < g.zfield + 1 ? xi : g.zfield + 1;
+}
+
+// copies values[sea_vertices] (heights, or any per-vertex quantity with the same
+// symmetry) from the fundamental region to the rest of a symmetric grid
+void sea_mirror(const SeaGrid &g, float *values, JobSystem *jobs = NULL);
+
+// same for normals[3*sea_vertices] of the continuous surface, flipping the
+// gradient: swapping x and z swaps its components, negating x and z negates it
+void sea_mirror_normals(const SeaGrid &g, float *normals, JobSystem *jobs = NULL);
+
+// fills heights[sea_vertices] with the wave model evaluated once per vertex,
+// through the vector batch evaluator (see wave_batch.h); only the fundamental
+// region is evaluated on symmetric grids
+void sea_heights(const SeaGrid &g, const WaveParams &w, float timer, float *heights, JobSystem *jobs = NULL);
+
+// fills normals[3*sea_vertices] with the sea normal above every vertex: e1^e2, with
+// e1 going to (xi+1,zi) and e2 to (xi,zi+1). The result is not normalized and
+// points downwards, into the water.
+void sea_normals(const SeaGrid &g, const float *heights, float *normals, JobSystem *jobs = NULL);
+
+// sea_heights() and analytic normals from wave_height_grad() in one evaluation
+// per vertex, mirrored from the fundamental region on symmetric grids. The normals follow the sea_normals() convention and scale, but are
+// exact for the continuous surface instead of spanning the neighbouring samples.
+void sea_heights_normals(const SeaGrid &g, const WaveParams &w, float timer, float *heights, float *normals,
+                         JobSystem *jobs = NULL);
+
+// fills uvs[2*sea_vertices] with the lightmap coordinates where the normal of
+// every vertex hits plane pl (see ray_plane.h; a normal parallel to the plane
+// maps the vertex itself)
+void sea_caustic_uvs(const SeaGrid &g, const float *heights, const float *normals, const plane &pl, float *uvs,
+                     JobSystem *jobs = NULL);
+
+// sea_caustic_uvs() for count planes in one pass over the normals, into uvs[p]
+// for plane p
+void sea_caustic_uvs_planes(const SeaGrid &g, const float *heights, const float *normals, const plane *planes,
+                            int count, float *const *uvs, JobSystem *jobs = NULL);
+
+// The sea mesh drawn by both passes: vertices (xi,zi) for xi in [-xfield, xfield]
+// and zi in [-zfield, zfield), stored x-major, and a static list of triangles
+// covering the quads between them. The same index list serves any vertex data
+// laid out on this grid.
+inline int sea_mesh_columns(const SeaGrid &g) { return 2 * g.xfield + 1; }
+inline int sea_mesh_rows(const SeaGrid &g) { return 2 * g.zfield; }
+inline int sea_mesh_vertices(const SeaGrid &g) { return sea_mesh_columns(g) * sea_mesh_rows(g); }
+inline int sea_mesh_index_count(const SeaGrid &g) { return 6 * (sea_mesh_columns(g) - 1) * (sea_mesh_rows(g) - 1); }
+
+// writes the triangle list of the mesh into indices[sea_mesh_index_count]
+void sea_mesh_indices(const SeaGrid &g, unsigned int *indices);
+
+// writes the mesh vertices as interleaved x,y,z,u,v floats into
+// out[5*sea_mesh_vertices]. With heights==NULL every vertex is laid flat at floor_y.
+// disp[2*sea_vertices], the horizontal dx,dz of every vertex, may be NULL.
+void sea_mesh(const SeaGrid &g, const float *heights, const float *disp, float floor_y, const float *uvs, float *out,
+              JobSystem *jobs = NULL);
+
+#endif
@@ -0,0 +1,62 @@
+#include "sim_clock.h"
+
+
+double WallClock::next_frame()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+bool ReplayClock::open(const char *path)
+{
+    times.clear();
+    frame = 0;
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+    double t;
+    while (fscanf(f, "%lf", &t) == 1)
+        times.push_back(t);
+    // anything left that is not a time means this is not a recording
+    bool ok = feof(f) && !times.empty();
+    fclose(f);
+    if (!ok)
+        times.clear();
+    return ok;
+}
+
+
+double ReplayClock::next_frame()
+{
+    if (times.empty())
+        return 0;
+    if (finished())
+        return times.back();
+    return times[frame++];
+}
+
+
+bool RecordingClock::open(const char *path)
+{
+    close();
+    file = fopen(path, "w");
+    return file != NULL;
+}
+
+
+void RecordingClock::close()
+{
+    if (file)
+        fclose(file);
+    file = NULL;
+}
+
+
+double RecordingClock::next_frame()
+{
+    double t = source->next_frame();
+    // enough digits to read back the same double
+    if (file)
+        fprintf(file, "%.17g\n", t);
+    return t;
+}
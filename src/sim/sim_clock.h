@@ -0,0 +1,86 @@
+#ifndef _SIM_CLOCK_INC
+#define _SIM_CLOCK_INC
+
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+
+// Time sources of the simulation. The frame loop asks its clock for the time of
+// every frame once, in ms, and hands that time to the wave models, so nothing in
+// the simulation reads a clock of its own:
+//  - WallClock: monotonic real time, for interactive viewing; the waves move at
+//    the same speed however busy the CPU is or how many threads build the sea.
+//  - FixedStepClock: frame i at start + i * step, whatever the frames cost, for
+//    benchmarks and offline renders that must come out the same on every run.
+//  - ReplayClock: the frame times of an earlier run, written by RecordingClock,
+//    to reproduce exactly the sea states a wall clock happened to produce.
+
+class SimClock
+{
+public:
+    virtual ~SimClock() {}
+    // time of the next frame in ms
+    virtual double next_frame() = 0;
+};
+
+class WallClock : public SimClock
+{
+public:
+    // counts from the construction
+    WallClock() : start(std::chrono::steady_clock::now()) {}
+    double next_frame();
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+class FixedStepClock : public SimClock
+{
+public:
+    explicit FixedStepClock(double step_ms, double start_ms = 0) : step(step_ms), start(start_ms), frame(0) {}
+    double next_frame() { return start + step * frame++; }
+
+private:
+    double step, start;
+    long frame;
+};
+
+// after the last recorded frame the time stays there
+class ReplayClock : public SimClock
+{
+public:
+    ReplayClock() : frame(0) {}
+
+    // one time in ms per line; false if the file is missing, holds something
+    // else or no time at all
+    bool open(const char *path);
+    int frames() const { return (int)times.size(); }
+    bool finished() const { return frame >= times.size(); }
+    double next_frame();
+
+private:
+    std::vector<double> times;
+    size_t frame;
+};
+
+// passes the times of source through and writes them to a file ReplayClock reads
+class RecordingClock : public SimClock
+{
+public:
+    explicit RecordingClock(SimClock *source) : source(source), file(NULL) {}
+    ~RecordingClock() { close(); }
+
+    // false if the file cannot be created
+    bool open(const char *path);
+    void close();
+    double next_frame();
+
+private:
+    RecordingClock(const RecordingClock &);
+    RecordingClock &operator=(const RecordingClock &);
+
+    SimClock *source;
+    FILE *file;
+};
+
+#endif
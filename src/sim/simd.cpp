@@ -0,0 +1,59 @@
+#include "simd.h"
+
+#if defined(OCEAN_SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+static bool simdForced = false;
+static SimdPath simdForcedPath = SIMD_SCALAR;
+
+
+SimdPath simd_detect()
+{
+#if defined(OCEAN_SIMD_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2")) return SIMD_SSE2;
+#elif defined(OCEAN_SIMD_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7)
+    {
+        int leaf1[4];
+        __cpuid(leaf1, 1);
+        __cpuidex(info, 7, 0);
+        // avx2 also needs the os to save the ymm registers
+        bool osxsave = (leaf1[2] & (1 << 27)) != 0;
+        if (osxsave && (info[1] & (1 << 5)) && (_xgetbv(0) & 6) == 6) return SIMD_AVX2;
+    }
+    return SIMD_SSE2;
+#endif
+    return SIMD_SCALAR;
+}
+
+
+SimdPath simd_path()
+{
+    static const SimdPath detected = simd_detect();
+    return simdForced ? simdForcedPath : detected;
+}
+
+
+void simd_force(SimdPath path)
+{
+    SimdPath best = simd_detect();
+    simdForcedPath = path < best ? path : best;
+    simdForced = true;
+}
+
+
+const char *simd_name(SimdPath path)
+{
+    switch (path)
+    {
+        case SIMD_AVX2: return "avx2";
+        case SIMD_SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef _SIMD_INC
+#define _SIMD_INC
+
+// Runtime selection of the vector instruction set used by the batch kernels.
+// Kernels are compiled for every path in the same binary; simd_path() picks
+// the best one the cpu supports, unless a path was forced (for comparisons).
+
+enum SimdPath
+{
+    SIMD_SCALAR = 0,
+    SIMD_SSE2,
+    SIMD_AVX2
+};
+
+SimdPath simd_detect();                 // best path supported by this cpu
+SimdPath simd_path();                   // path used by the batch kernels
+void simd_force(SimdPath path);         // clamped to what the cpu supports
+const char *simd_name(SimdPath path);
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define OCEAN_SIMD_X86 1
+#if defined(__GNUC__)
+#define OCEAN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define OCEAN_TARGET_AVX2
+#endif
+#endif
+
+// Unrolls the fixed-count octave loops; only gcc and clang understand the pragma.
+#if defined(__GNUC__)
+#define OCEAN_UNROLL8 _Pragma("GCC unroll 8")
+#else
+#define OCEAN_UNROLL8
+#endif
+
+#endif
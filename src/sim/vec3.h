@@ -0,0 +1,95 @@
+#ifndef _VEC3_INC
+#define _VEC3_INC
+
+#include <math.h>
+
+// Small 3d vector for the simulation hot paths, in float or double. Unlike
+// point everything is inline and passed by reference, the operators are
+// constexpr and there is nothing but the three components, so arrays of vec3
+// are plain interleaved x,y,z data and the compiler keeps temporaries in
+// registers. Arrays of many vectors are best kept as three separate component
+// arrays (structure of arrays); the vec3_soa helpers below work on those.
+
+template <typename T>
+struct vec3
+{
+    T x, y, z;
+
+    constexpr vec3() : x(0), y(0), z(0) {}
+    constexpr vec3(T px, T py, T pz) : x(px), y(py), z(pz) {}
+    template <typename U>
+    constexpr explicit vec3(const vec3<U> &v) : x((T)v.x), y((T)v.y), z((T)v.z) {}
+
+    constexpr vec3 operator+(const vec3 &v) const { return vec3(x + v.x, y + v.y, z + v.z); }
+    constexpr vec3 operator-(const vec3 &v) const { return vec3(x - v.x, y - v.y, z - v.z); }
+    constexpr vec3 operator-() const { return vec3(-x, -y, -z); }
+    constexpr vec3 operator*(T s) const { return vec3(x * s, y * s, z * s); }
+    constexpr vec3 operator/(T s) const { return vec3(x / s, y / s, z / s); }
+    constexpr bool operator==(const vec3 &v) const { return x == v.x && y == v.y && z == v.z; }
+    constexpr bool operator!=(const vec3 &v) const { return !(*this == v); }
+
+    vec3 &operator+=(const vec3 &v) { x += v.x; y += v.y; z += v.z; return *this; }
+    vec3 &operator-=(const vec3 &v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+    vec3 &operator*=(T s) { x *= s; y *= s; z *= s; return *this; }
+};
+
+typedef vec3<float> vec3f;
+typedef vec3<double> vec3d;
+
+template <typename T>
+constexpr vec3<T> operator*(T s, const vec3<T> &v) { return v * s; }
+
+template <typename T>
+constexpr T dot(const vec3<T> &a, const vec3<T> &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+// same component order as point::operator^
+template <typename T>
+constexpr vec3<T> cross(const vec3<T> &a, const vec3<T> &b)
+{
+    return vec3<T>(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+template <typename T>
+constexpr T length_sq(const vec3<T> &v) { return dot(v, v); }
+
+template <typename T>
+inline T length(const vec3<T> &v) { return sqrt(dot(v, v)); }
+
+// the zero vector stays zero, as in point::normalize()
+template <typename T>
+inline vec3<T> normalize(const vec3<T> &v)
+{
+    T m = length(v);
+    return m != 0 ? v / m : vec3<T>();
+}
+
+// interleaved x,y,z arrays
+template <typename T>
+inline vec3<T> vec3_load(const T *p) { return vec3<T>(p[0], p[1], p[2]); }
+
+template <typename T>
+inline void vec3_store(T *p, const vec3<T> &v)
+{
+    p[0] = v.x;
+    p[1] = v.y;
+    p[2] = v.z;
+}
+
+// structure of arrays: stores v as element i of the component arrays x, y and z
+template <typename T>
+inline void vec3_soa_store(T *x, T *y, T *z, int i, const vec3<T> &v)
+{
+    x[i] = v.x;
+    y[i] = v.y;
+    z[i] = v.z;
+}
+
+// splits n interleaved vectors into component arrays
+template <typename T>
+inline void vec3_soa_split(const T *xyz, int n, T *x, T *y, T *z)
+{
+    for (int i = 0; i < n; i++)
+        vec3_soa_store(x, y, z, i, vec3_load(xyz + 3 * i));
+}
+
+#endif
@@ -0,0 +1,54 @@
+#include <math.h>
+#include "wave.h"
+
+
+float wave_height(const WaveParams &w, float x, float z, float timer)
+{
+    float y = w.level;
+
+    float factor = 1.0f;
+    float d = sqrt(x * x + z * z);
+    d = d / 40.0f;
+    if (d > 1.5) d = 1.5f;
+    if (d < 0) d = 0;
+    for (int i = 0; i < w.octaves; i++)
+    {
+        y -= factor * w.vtxsize * d * cosf((timer * w.speed) + (1 / factor) * x * z * w.wavesize) +
+             (factor) * w.vtxsize * d * sinf((timer * w.speed) + (1 / factor) * x * z * w.wavesize);
+        factor = factor / 2.0f;
+    }
+    return y;
+}
+
+
+float wave_height_grad(const WaveParams &w, float x, float z, float timer, float *dhdx, float *dhdz)
+{
+    float y = w.level;
+    float gx = 0, gz = 0;
+
+    float factor = 1.0f;
+    float r = sqrt(x * x + z * z);
+    float d = r / 40.0f;
+    // d is clamped past r = 60, and its derivative with it
+    float ddx = 0, ddz = 0;
+    if (d > 1.5) d = 1.5f;
+    else if (r > 0)
+    {
+        ddx = x / (40.0f * r);
+        ddz = z / (40.0f * r);
+    }
+    for (int i = 0; i < w.octaves; i++)
+    {
+        // one cos and one sin per octave serve the height and both derivatives
+        float a = (timer * w.speed) + (1 / factor) * x * z * w.wavesize;
+        float c = cosf(a);
+        float s = sinf(a);
+        y -= factor * w.vtxsize * d * c + (factor) * w.vtxsize * d * s;
+        gx -= w.vtxsize * (factor * ddx * (c + s) + d * (c - s) * z * w.wavesize);
+        gz -= w.vtxsize * (factor * ddz * (c + s) + d * (c - s) * x * w.wavesize);
+        factor = factor / 2.0f;
+    }
+    *dhdx = gx;
+    *dhdz = gz;
+    return y;
+}
@@ -0,0 +1,26 @@
+#ifndef _WAVE_INC
+#define _WAVE_INC
+
+// Multi-octave trig wave model. Every octave halves the amplitude and
+// doubles the spatial frequency of a cos+sin pair travelling with the
+// simulation timer. Coordinates are grid indices, not world units.
+
+struct WaveParams
+{
+    int octaves = 5;
+    float speed = 0.008f;       // phase advance per ms of simulation time
+    float wavesize = 3.0f;      // spatial frequency of the x*z term
+    float vtxsize = 0.05f;      // amplitude of the first octave
+    float level = 4.5f;         // rest height of the sea
+};
+
+// height of the sea at grid position (x,z) at time timer (ms)
+float wave_height(const WaveParams &w, float x, float z, float timer);
+
+// wave_height() together with its exact partial derivatives along x and z, per
+// grid index. The gradient is that of the continuous surface: on the default
+// grid the x*z phase moves by tens of radians between neighbouring vertices,
+// so it can differ completely from the slope between two samples.
+float wave_height_grad(const WaveParams &w, float x, float z, float timer, float *dhdx, float *dhdz);
+
+#endif
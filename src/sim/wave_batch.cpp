@@ -0,0 +1,34 @@
+#include <math.h>
+#include <vector>
+#include "wave_kernel.h"
+#include "wave_batch.h"
+
+
+void wave_height_batch(const WaveParams &w, const float *x, const float *z, int n, float timer, float *heights)
+{
+    // the scalar path keeps libm, so it matches wave_height() exactly
+    if (simd_path() == SIMD_SCALAR)
+        wave_kernel_batch<MATH_LIBM>(w, x, z, n, timer, heights);
+    else
+        wave_kernel_batch<MATH_ACCURATE>(w, x, z, n, timer, heights);
+}
+
+
+float wave_height_batch_error(const WaveParams &w, int xfield, int zfield, float timer)
+{
+    int depth = 2 * zfield + 2;
+    std::vector<float> x(depth), z(depth), heights(depth);
+    float err = 0;
+    for (int xi = -xfield; xi <= xfield + 1; xi++)
+    {
+        for (int k = 0; k < depth; k++)
+        {
+            x[k] = xi;
+            z[k] = k - zfield;
+        }
+        wave_height_batch(w, x.data(), z.data(), depth, timer, heights.data());
+        for (int k = 0; k < depth; k++)
+            err = fmaxf(err, fabsf(heights[k] - wave_height(w, x[k], z[k], timer)));
+    }
+    return err;
+}
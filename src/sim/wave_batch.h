@@ -0,0 +1,25 @@
+#ifndef _WAVE_BATCH_INC
+#define _WAVE_BATCH_INC
+
+#include "wave.h"
+
+// Batch evaluation of the wave model: heights[i] = wave_height(w, x[i], z[i], timer)
+// for n points, 8 at a time with AVX2, 4 with SSE2, or one by one on the scalar
+// path, as chosen by simd_path(). The vector paths replace libm cosf/sinf with a
+// polynomial sincos (MATH_ACCURATE in fast_math.h) whose argument is reduced in
+// double precision, so phases of 1e5 radians and more (x*z terms on large grids)
+// keep full accuracy. Vector heights stay within WAVE_BATCH_TOLERANCE of
+// wave_height() for phases up to 1e10 radians, which covers every grid up to
+// SEA_MAX_FIELD with 8 octaves; the scalar path is exact. The
+// work is done by the WaveKernel instantiation for the current octave count
+// (wave_kernel.h).
+
+#define WAVE_BATCH_TOLERANCE 2e-6f
+
+void wave_height_batch(const WaveParams &w, const float *x, const float *z, int n, float timer, float *heights);
+
+// largest |wave_height_batch - wave_height| over the grid [-xfield, xfield+1] x
+// [-zfield, zfield+1], on the current simd path
+float wave_height_batch_error(const WaveParams &w, int xfield, int zfield, float timer);
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef _WAVE_KERNEL_INC
+#define _WAVE_KERNEL_INC
+
+#include <math.h>
+#include "wave.h"
+#include "fast_math.h"
+
+// Trig wave kernels specialized at compile time. WaveKernel<Octaves, Precision>
+// evaluates the model of wave.h with the octave count fixed, so the octave loop
+// has a constant trip count and the amplitude and frequency factors of every
+// octave are constants: the compiler unrolls the sum and keeps it in registers
+// instead of halving a factor from one iteration to the next. Octaves = 0 is
+// the generic kernel, which reads the count from WaveParams at run time.
+// Precision is the fast_math.h tier of the sin/cos pair.
+//
+// The phase of octave o is (1/factor)*x*z*wavesize with 1/factor = 2^o; a power
+// of two scales through a rounding exactly, so x*z*wavesize is computed once
+// per vertex and the MATH_LIBM scalar kernel is bit-identical to wave_height().
+//
+// wave_kernel_batch() picks the instantiation for the current octave count
+// (1 to WAVE_KERNEL_MAX_OCTAVES, the generic kernel past that) and the simd
+// path, as wave_height_batch() does.
+
+#define WAVE_KERNEL_MAX_OCTAVES 8
+
+// amplitude factor of octave o, 1/2^o
+constexpr float wave_octave_factor(int o)
+{
+    float f = 1.0f;
+    for (int i = 0; i < o; i++)
+        f = f / 2.0f;
+    return f;
+}
+
+// frequency factor of octave o, 2^o
+constexpr float wave_octave_scale(int o)
+{
+    float f = 1.0f;
+    for (int i = 0; i < o; i++)
+        f = f * 2.0f;
+    return f;
+}
+
+
+template <int Octaves, MathTier Precision>
+struct WaveKernel
+{
+    static_assert(Octaves >= 0 && Octaves <= WAVE_KERNEL_MAX_OCTAVES, "unsupported octave count");
+
+    static int octaves(const WaveParams &w) { return Octaves > 0 ? Octaves : w.octaves; }
+
+    static float height(const WaveParams &w, float x, float z, float timer)
+    {
+        float d = sqrtf(x * x + z * z) / 40.0f;
+        if (d > 1.5f) d = 1.5f;
+        float t = timer * w.speed;
+        float p = x * z * w.wavesize;
+        float vd = w.vtxsize * d;
+        float y = w.level;
+        int count = octaves(w);
+        OCEAN_UNROLL8
+        for (int o = 0; o < count; o++)
+        {
+            float s, c;
+            fast_sincos<Precision>(t + wave_octave_scale(o) * p, &s, &c);
+            float amp = wave_octave_factor(o) * vd;
+            y -= amp * c + amp * s;
+        }
+        return y;
+    }
+
+    static void scalar(const WaveParams &w, const float *x, const float *z, int n, float timer, float *heights)
+    {
+        for (int i = 0; i < n; i++)
+            heights[i] = height(w, x[i], z[i], timer);
+    }
+
+#ifdef OCEAN_SIMD_X86
+
+    static void sse2(const WaveParams &w, const float *x, const float *z, int n, float timer, float *heights)
+    {
+        const __m128 t = _mm_set1_ps(timer * w.speed);
+        const __m128 wavesize = _mm_set1_ps(w.wavesize);
+        const __m128 vtxsize = _mm_set1_ps(w.vtxsize);
+        int count = octaves(w);
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 vx = _mm_loadu_ps(x + i);
+            __m128 vz = _mm_loadu_ps(z + i);
+            __m128 d = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vz, vz)));
+            d = _mm_min_ps(_mm_div_ps(d, _mm_set1_ps(40.0f)), _mm_set1_ps(1.5f));
+            __m128 p = _mm_mul_ps(_mm_mul_ps(vx, vz), wavesize);
+            __m128 vd = _mm_mul_ps(vtxsize, d);
+            __m128 y = _mm_set1_ps(w.level);
+            OCEAN_UNROLL8
+            for (int o = 0; o < count; o++)
+            {
+                __m128 s, c;
+                fast_sincos_sse2<Precision>(_mm_add_ps(t, _mm_mul_ps(_mm_set1_ps(wave_octave_scale(o)), p)), &s, &c);
+                __m128 amp = _mm_mul_ps(_mm_set1_ps(wave_octave_factor(o)), vd);
+                y = _mm_sub_ps(y, _mm_mul_ps(amp, _mm_add_ps(c, s)));
+            }
+            _mm_storeu_ps(heights + i, y);
+        }
+        scalar(w, x + i, z + i, n - i, timer, heights + i);
+    }
+
+    OCEAN_TARGET_AVX2
+    static void avx2(const WaveParams &w, const float *x, const float *z, int n, float timer, float *heights)
+    {
+        const __m256 t = _mm256_set1_ps(timer * w.speed);
+        const __m256 wavesize = _mm256_set1_ps(w.wavesize);
+        const __m256 vtxsize = _mm256_set1_ps(w.vtxsize);
+        int count = octaves(w);
+        int i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256 vx = _mm256_loadu_ps(x + i);
+            __m256 vz = _mm256_loadu_ps(z + i);
+            __m256 d = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vz, vz)));
+            d = _mm256_min_ps(_mm256_div_ps(d, _mm256_set1_ps(40.0f)), _mm256_set1_ps(1.5f));
+            __m256 p = _mm256_mul_ps(_mm256_mul_ps(vx, vz), wavesize);
+            __m256 vd = _mm256_mul_ps(vtxsize, d);
+            __m256 y = _mm256_set1_ps(w.level);
+            OCEAN_UNROLL8
+            for (int o = 0; o < count; o++)
+            {
+                __m256 s, c;
+                fast_sincos_avx2<Precision>(_mm256_add_ps(t, _mm256_mul_ps(_mm256_set1_ps(wave_octave_scale(o)), p)),
+                                            &s, &c);
+                __m256 amp = _mm256_mul_ps(_mm256_set1_ps(wave_octave_factor(o)), vd);
+                y = _mm256_sub_ps(y, _mm256_mul_ps(amp, _mm256_add_ps(c, s)));
+            }
+            _mm256_storeu_ps(heights + i, y);
+        }
+        sse2(w, x + i, z + i, n - i, timer, heights + i);
+    }
+
+#endif
+
+    static void batch(const WaveParams &w, const float *x, const float *z, int n, float timer, float *heights)
+    {
+#ifdef OCEAN_SIMD_X86
+        switch (simd_path())
+        {
+            case SIMD_AVX2: avx2(w, x, z, n, timer, heights); return;
+            case SIMD_SSE2: sse2(w, x, z, n, timer, heights); return;
+            default: break;
+        }
+#endif
+        scalar(w, x, z, n, timer, heights);
+    }
+};
+
+
+template <MathTier Precision>
+void wave_kernel_batch(const WaveParams &w, const float *x, const float *z, int n, float timer, float *heights)
+{
+    switch (w.octaves)
+    {
+        case 1: WaveKernel<1, Precision>::batch(w, x, z, n, timer, heights); return;
+        case 2: WaveKernel<2, Precision>::batch(w, x, z, n, timer, heights); return;
+        case 3: WaveKernel<3, Precision>::batch(w, x, z, n, timer, heights); return;
+        case 4: WaveKernel<4, Precision>::batch(w, x, z, n, timer, heights); return;
+        case 5: WaveKernel<5, Precision>::batch(w, x, z, n, timer, heights); return;
+        case 6: WaveKernel<6, Precision>::batch(w, x, z, n, timer, heights); return;
+        case 7: WaveKernel<7, Precision>::batch(w, x, z, n, timer, heights); return;
+        case 8: WaveKernel<8, Precision>::batch(w, x, z, n, timer, heights); return;
+        default: WaveKernel<0, Precision>::batch(w, x, z, n, timer, heights); return;
+    }
+}
+
+#endif
@@ -0,0 +1,103 @@
+#include <math.h>
+#include <vector>
+#include "wave_strip.h"
+
+// columns handed to a job at a time
+#define STRIP_GRAIN 8
+
+
+static double wave_distance(double x, double z)
+{
+    double d = sqrt(x * x + z * z) / 40.0;
+    return d > 1.5 ? 1.5 : d;
+}
+
+
+void wave_height_strip(const WaveParams &w, int x, int z0, int n, float timer, float *heights)
+{
+    // one rotation per octave; the octaves advance together, so their
+    // independent recurrences overlap instead of waiting on each other
+    int octaves = w.octaves;
+    // kept per thread, every strip of a frame reuses them
+    static thread_local std::vector<double> scratch;
+    scratch.resize(5 * octaves);
+    double *c = &scratch[0], *s = c + octaves, *cstep = s + octaves, *sstep = cstep + octaves;
+    double *amp = sstep + octaves;
+    double t = timer * w.speed;
+    double factor = 1;
+    for (int o = 0; o < octaves; o++)
+    {
+        double step = (1 / factor) * x * w.wavesize;
+        c[o] = cos(t + step * z0);
+        s[o] = sin(t + step * z0);
+        cstep[o] = cos(step);
+        sstep[o] = sin(step);
+        amp[o] = factor * w.vtxsize;
+        factor = factor / 2;
+    }
+    for (int i0 = 0; i0 < n; i0 += WAVE_STRIP_RENORM)
+    {
+        int i1 = i0 + WAVE_STRIP_RENORM < n ? i0 + WAVE_STRIP_RENORM : n;
+        for (int i = i0; i < i1; i++)
+        {
+            double sum = 0;
+            for (int o = 0; o < octaves; o++)
+            {
+                sum += amp[o] * (c[o] + s[o]);
+                double cn = c[o] * cstep[o] - s[o] * sstep[o];
+                s[o] = s[o] * cstep[o] + c[o] * sstep[o];
+                c[o] = cn;
+            }
+            heights[i] = (float)(w.level - wave_distance(x, z0 + i) * sum);
+        }
+        for (int o = 0; o < octaves; o++)
+        {
+            double l = 1 / sqrt(c[o] * c[o] + s[o] * s[o]);
+            c[o] *= l;
+            s[o] *= l;
+        }
+    }
+}
+
+
+void sea_heights_strip(const SeaGrid &g, const WaveParams &w, float timer, float *heights, JobSystem *jobs)
+{
+    bool symmetric = sea_symmetric(g);
+    parallel_for(jobs, symmetric ? 0 : -g.xfield, g.xfield + 2, STRIP_GRAIN, [&](int first, int last) {
+        for (int xi = first; xi < last; xi++)
+        {
+            int z0 = -g.zfield, z1 = g.zfield + 1;
+            if (symmetric)
+                sea_fundamental_range(g, xi, &z0, &z1);
+            wave_height_strip(w, xi, z0, z1 - z0 + 1, timer, &heights[sea_index(g, xi, z0)]);
+        }
+    });
+    if (symmetric)
+        sea_mirror(g, heights, jobs);
+}
+
+
+double wave_height_strip_error(const WaveParams &w, int xfield, int zfield, float timer)
+{
+    int depth = 2 * zfield + 2;
+    std::vector<float> heights(depth);
+    double t = timer * w.speed;
+    double err = 0;
+    for (int xi = -xfield; xi <= xfield + 1; xi++)
+    {
+        wave_height_strip(w, xi, -zfield, depth, timer, heights.data());
+        for (int i = 0; i < depth; i++)
+        {
+            int zi = i - zfield;
+            double y = w.level, factor = 1;
+            for (int o = 0; o < w.octaves; o++)
+            {
+                double a = t + (1 / factor) * xi * zi * w.wavesize;
+                y -= factor * w.vtxsize * wave_distance(xi, zi) * (cos(a) + sin(a));
+                factor = factor / 2;
+            }
+            err = fmax(err, fabs(heights[i] - y));
+        }
+    }
+    return err;
+}
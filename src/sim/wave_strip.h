@@ -0,0 +1,33 @@
+#ifndef _WAVE_STRIP_INC
+#define _WAVE_STRIP_INC
+
+#include <stddef.h>
+#include "wave.h"
+#include "sea.h"
+#include "jobs.h"
+
+// Strip evaluation of the trig wave model without per-vertex trig calls. Along
+// a strip of constant x the phase of every octave, timer*speed +
+// (1/factor)*x*z*wavesize, grows by the same angle (1/factor)*x*wavesize from
+// one z to the next, so its cos and sin advance by a rotation:
+//   c' = c cos(step) - s sin(step),   s' = s cos(step) + c sin(step)
+// The rotation runs in double precision and (c,s) is scaled back to unit
+// length every WAVE_STRIP_RENORM vertices, which bounds the drift on strips of
+// any length. Unlike the phase table (wave_table.h) nothing is stored per
+// vertex, so very large grids stream through no memory but their output.
+
+#define WAVE_STRIP_RENORM 16
+
+// heights[i] = wave_height(w, x, z0 + i, timer) for i in [0, n)
+void wave_height_strip(const WaveParams &w, int x, int z0, int n, float timer, float *heights);
+
+// fills heights[sea_vertices] with one strip per grid column
+void sea_heights_strip(const SeaGrid &g, const WaveParams &w, float timer, float *heights, JobSystem *jobs = NULL);
+
+// largest difference between the strip heights and a direct double precision
+// evaluation of the wave model over the grid [-xfield, xfield+1] x [-zfield, zfield+1],
+// within WAVE_STRIP_TOLERANCE for any grid size and timer
+#define WAVE_STRIP_TOLERANCE 1e-6
+double wave_height_strip_error(const WaveParams &w, int xfield, int zfield, float timer);
+
+#endif
@@ -0,0 +1,86 @@
+#include <math.h>
+#include "wave_table.h"
+
+// columns handed to a job at a time
+#define TABLE_GRAIN 8
+
+
+void wave_table_build(WaveTable &t, const SeaGrid &g, const WaveParams &w, JobSystem *jobs)
+{
+    t.grid = g;
+    t.params = w;
+    t.p.resize(sea_vertices(g));
+    t.q.resize(sea_vertices(g));
+    // p and q have the symmetry of the wave model: build the fundamental region and mirror it
+    bool symmetric = sea_symmetric(g);
+    parallel_for(jobs, symmetric ? 0 : -g.xfield, g.xfield + 2, TABLE_GRAIN, [&](int first, int last) {
+        for (int xi = first; xi < last; xi++)
+        {
+            int z0 = -g.zfield, z1 = g.zfield + 1;
+            if (symmetric)
+                sea_fundamental_range(g, xi, &z0, &z1);
+            for (int zi = z0; zi <= z1; zi++)
+            {
+                double d = sqrt((double)xi * xi + (double)zi * zi) / 40.0;
+                if (d > 1.5) d = 1.5;
+                double p = 0, q = 0, factor = 1;
+                for (int o = 0; o < w.octaves; o++)
+                {
+                    double phi = (1 / factor) * xi * zi * w.wavesize;
+                    double c = cos(phi), s = sin(phi);
+                    double amp = factor * w.vtxsize * d;
+                    p += amp * (c + s);
+                    q += amp * (c - s);
+                    factor = factor / 2;
+                }
+                int k = sea_index(g, xi, zi);
+                t.p[k] = (float)p;
+                t.q[k] = (float)q;
+            }
+        }
+    });
+    if (symmetric)
+    {
+        sea_mirror(g, t.p.data(), jobs);
+        sea_mirror(g, t.q.data(), jobs);
+    }
+}
+
+
+bool wave_table_matches(const WaveTable &t, const SeaGrid &g, const WaveParams &w)
+{
+    return t.grid.xfield == g.xfield && t.grid.zfield == g.zfield && t.params.octaves == w.octaves &&
+           t.params.wavesize == w.wavesize && t.params.vtxsize == w.vtxsize &&
+           (int)t.p.size() == sea_vertices(g);
+}
+
+
+void wave_table_heights(const WaveTable &t, const WaveParams &w, float timer, float *heights, JobSystem *jobs)
+{
+    // the one sin/cos pair of the frame
+    double a = timer * w.speed;
+    float c = (float)cos(a), s = (float)sin(a);
+    const SeaGrid &g = t.grid;
+    int depth = sea_depth(g);
+    parallel_for(jobs, -g.xfield, g.xfield + 2, TABLE_GRAIN, [&](int first, int last) {
+        int begin = sea_index(g, first, -g.zfield);
+        int end = begin + (last - first) * depth;
+        const float *p = t.p.data();
+        const float *q = t.q.data();
+        for (int k = begin; k < end; k++)
+            heights[k] = w.level - c * p[k] - s * q[k];
+    });
+}
+
+
+float wave_table_error(const WaveTable &t, const WaveParams &w, float timer)
+{
+    const SeaGrid &g = t.grid;
+    std::vector<float> heights(sea_vertices(g));
+    wave_table_heights(t, w, timer, heights.data());
+    float err = 0;
+    for (int xi = -g.xfield; xi <= g.xfield + 1; xi++)
+        for (int zi = -g.zfield; zi <= g.zfield + 1; zi++)
+            err = fmaxf(err, fabsf(heights[sea_index(g, xi, zi)] - wave_height(w, xi, zi, timer)));
+    return err;
+}
@@ -0,0 +1,43 @@
+#ifndef _WAVE_TABLE_INC
+#define _WAVE_TABLE_INC
+
+#include <stddef.h>
+#include <vector>
+#include "wave.h"
+#include "sea.h"
+#include "jobs.h"
+
+// Phase table of the trig wave model over a sea grid. In wave_height() every
+// octave's phase is timer*speed + phi, where phi = (1/factor)*x*z*wavesize only
+// depends on the vertex. With the angle addition formulas
+//   cos(t+phi) + sin(t+phi) = cos(t) (cos phi + sin phi) + sin(t) (cos phi - sin phi)
+// and t shared by all octaves, the octave sum of a vertex folds into two
+// time-invariant coefficients:
+//   height = level - cos(t) p - sin(t) q
+// so a frame costs one sin/cos pair in total and two multiply-adds per vertex.
+// The table is built in double precision, which also removes the float phase
+// rounding of wave_height() at large x*z.
+
+struct WaveTable
+{
+    SeaGrid grid;
+    WaveParams params;
+    std::vector<float> p, q;    // per sea slot, see sea_index()
+};
+
+// fills t for grid g and parameters w
+void wave_table_build(WaveTable &t, const SeaGrid &g, const WaveParams &w, JobSystem *jobs = NULL);
+
+// true when t was built for g and w. The level and speed are applied per frame
+// and do not need a rebuild.
+bool wave_table_matches(const WaveTable &t, const SeaGrid &g, const WaveParams &w);
+
+// fills heights[sea_vertices] of the table's grid at time timer, with w's level and speed
+void wave_table_heights(const WaveTable &t, const WaveParams &w, float timer, float *heights, JobSystem *jobs = NULL);
+
+// largest |wave_table_heights - wave_height| over the grid. Within
+// WAVE_BATCH_TOLERANCE when timer*speed is a whole number; at other timers
+// wave_height()'s own float phase rounding dominates on large grids.
+float wave_table_error(const WaveTable &t, const WaveParams &w, float timer);
+
+#endif
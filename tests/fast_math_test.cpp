@@ -0,0 +1,57 @@
+// Accuracy report of fast_math.h: every function on every tier and simd path
+// the cpu supports, over the tier's valid range, against the exact result.
+// Prints the largest ulp, absolute and relative errors and fails when one
+// exceeds the bound documented for the tier in fast_math.h.
+
+#include <stdio.h>
+#include "fast_math.h"
+
+#define SAMPLES (1 << 20)
+
+
+static float sincos_range(MathTier tier)
+{
+    switch (tier)
+    {
+        case MATH_FAST: return FM_RANGE_FAST;
+        case MATH_FASTEST: return FM_RANGE_FASTEST;
+        default: return FM_RANGE_ACCURATE;
+    }
+}
+
+
+// whether acc is within the documented bound of f on tier
+static bool within_bound(MathFunction f, MathTier tier, const MathAccuracy &acc)
+{
+    bool rsqrt = f == MATH_RSQRT;
+    switch (tier)
+    {
+        case MATH_FAST: return acc.max_ulp <= (rsqrt ? FM_MAX_ULP_FAST_RSQRT : FM_MAX_ULP_FAST_SINCOS);
+        case MATH_FASTEST: return rsqrt ? acc.max_rel <= FM_MAX_REL_FASTEST_RSQRT : acc.max_abs <= FM_MAX_ABS_FASTEST_SINCOS;
+        default: return acc.max_ulp <= FM_MAX_ULP_ACCURATE;
+    }
+}
+
+
+int main()
+{
+    int failures = 0;
+    printf("%-6s %-9s %-6s %10s %12s %12s %14s\n", "func", "tier", "path", "max ulp", "max abs", "max rel", "worst arg");
+    for (int f = MATH_SIN; f <= MATH_RSQRT; f++)
+        for (int t = MATH_LIBM; t <= MATH_FASTEST; t++)
+            for (int p = SIMD_SCALAR; p <= SIMD_AVX2; p++)
+            {
+                if (p > simd_detect())
+                    continue;
+                MathFunction fn = (MathFunction)f;
+                MathTier tier = (MathTier)t;
+                float range = sincos_range(tier);
+                MathAccuracy acc = fn == MATH_RSQRT ? fast_math_accuracy(fn, tier, (SimdPath)p, 1e-30f, 1e30f, SAMPLES)
+                                                    : fast_math_accuracy(fn, tier, (SimdPath)p, -range, range, SAMPLES);
+                bool ok = within_bound(fn, tier, acc);
+                printf("%-6s %-9s %-6s %10.3f %12.3g %12.3g %14.7g%s\n", math_function_name(fn), math_tier_name(tier),
+                       simd_name((SimdPath)p), acc.max_ulp, acc.max_abs, acc.max_rel, acc.worst, ok ? "" : "  FAILED");
+                failures += !ok;
+            }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,72 @@
+// Checks that FftOcean draws a Hermitian spectrum, so that every field it
+// transforms is real. With no choppiness the imaginary half of the height
+// transform comes out as disp_x, and the real half of i*kx*h as disp_z; both
+// must vanish. The heights must not change with the choppiness or with the
+// number of job threads. Fails when a field is off by more than
+// FFT_OCEAN_TOLERANCE of the largest height.
+
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "fft_ocean.h"
+
+#define FFT_OCEAN_TOLERANCE 1e-5f
+
+
+static float max_abs(const std::vector<float> &v)
+{
+    float m = 0;
+    for (float x : v)
+        m = fmaxf(m, fabsf(x));
+    return m;
+}
+
+
+static float max_diff(const std::vector<float> &a, const std::vector<float> &b)
+{
+    float m = 0;
+    for (size_t i = 0; i < a.size(); i++)
+        m = fmaxf(m, fabsf(a[i] - b[i]));
+    return m;
+}
+
+
+int main()
+{
+    const int sizes[] = {16, 64, 128};
+    const OceanSpectrum spectra[] = {SPECTRUM_PHILLIPS, SPECTRUM_JONSWAP};
+    const float times[] = {0, 1.5f, 1000};
+    JobSystem jobs(4);
+    int failures = 0;
+    for (int n : sizes)
+        for (OceanSpectrum spectrum : spectra)
+        {
+            FftOceanParams params;
+            params.n = n;
+            params.spectrum = spectrum;
+            params.choppiness = 0;
+            FftOcean flat(params);
+            params.choppiness = 1;
+            FftOcean choppy(params);
+
+            size_t count = n * n;
+            std::vector<float> height(count), dx(count), dz(count), choppyHeight(count), jobHeight(count);
+            float worst = 0, scale = 0;
+            for (float t : times)
+            {
+                flat.evaluate(t, height.data(), dx.data(), dz.data(), NULL, NULL);
+                choppy.evaluate(t, choppyHeight.data(), NULL, NULL, NULL, NULL);
+                choppy.evaluate(t, jobHeight.data(), NULL, NULL, NULL, NULL, &jobs);
+                float h = max_abs(height);
+                scale = fmaxf(scale, h);
+                float err = fmaxf(fmaxf(max_abs(dx), max_abs(dz)),
+                                  fmaxf(max_diff(height, choppyHeight), max_diff(height, jobHeight)));
+                worst = fmaxf(worst, h > 0 ? err / h : 1);
+            }
+            bool ok = scale > 0 && worst <= FFT_OCEAN_TOLERANCE;
+            printf("n %3d %-8s: max height %g, relative error %g%s\n", n,
+                   spectrum == SPECTRUM_PHILLIPS ? "phillips" : "jonswap", scale, worst, ok ? "" : "  FAILED");
+            failures += !ok;
+        }
+    return failures ? 1 : 0;
+}
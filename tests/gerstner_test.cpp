@@ -0,0 +1,61 @@
+// Checks gerstner_sea() on every simd path the cpu supports against the
+// gerstner_point() reference, for wave sets that do and do not fill whole
+// vectors, at small and large times. Fails when a height or normal differs by
+// more than GERSTNER_SEA_TOLERANCE.
+
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "simd.h"
+#include "gerstner.h"
+
+
+// largest difference between gerstner_point() and gerstner_sea() at the grid corners and centre
+static float point_error(const SeaGrid &g, const GerstnerWaves &w, float t)
+{
+    std::vector<float> heights(sea_vertices(g)), normals(3 * sea_vertices(g));
+    gerstner_sea(g, w, t, 0, heights.data(), normals.data(), NULL);
+    const int xs[] = {-g.xfield, 0, g.xfield + 1}, zs[] = {-g.zfield, 0, g.zfield + 1};
+    float err = 0;
+    for (int xi : xs)
+        for (int zi : zs)
+        {
+            int k = sea_index(g, xi, zi);
+            float h, n[3];
+            gerstner_point(w, xi * g.quadsize, zi * g.quadsize, t, &h, n, NULL);
+            err = fmaxf(err, fabsf(heights[k] - h));
+            for (int c = 0; c < 3; c++)
+                err = fmaxf(err, fabsf(normals[3 * k + c] - n[c]));
+        }
+    return err;
+}
+
+
+int main()
+{
+    const int counts[] = {1, 5, 32};
+    const float times[] = {0, 10, 1000};
+    SeaGrid g;
+    int failures = 0;
+    for (int p = SIMD_SCALAR; p <= SIMD_AVX2; p++)
+    {
+        simd_force((SimdPath)p);
+        if (simd_path() != p)
+        {
+            printf("%-6s not supported, skipped\n", simd_name((SimdPath)p));
+            continue;
+        }
+        for (int count : counts)
+        {
+            GerstnerWaves w = gerstner_wind_waves(count, 4.0f, 0.02f, 1.0f, 0.6f, 0.6f);
+            float worst = 0;
+            for (float t : times)
+                worst = fmaxf(worst, fmaxf(gerstner_sea_error(g, w, t), point_error(g, w, t)));
+            bool ok = worst <= GERSTNER_SEA_TOLERANCE;
+            printf("%-6s %2d waves: max error %g%s\n", simd_name((SimdPath)p), count, worst, ok ? "" : "  FAILED");
+            failures += !ok;
+        }
+    }
+    simd_force(simd_detect());
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+// Checks the trig sea stages that only evaluate the fundamental region of a
+// symmetric grid and mirror it (sea_heights, sea_heights_normals,
+// sea_heights_strip and the phase table) against wave_height() and
+// wave_height_grad() evaluated at every vertex, on the smallest square grids,
+// where the region is a handful of vertices, and on a larger odd one. The
+// outputs start as NaN, so a vertex the mirror misses fails. Timers keep
+// timer*speed whole, where wave_height() is exact enough to compare with (see
+// wave_table_test.cpp). Fails when an error exceeds WAVE_BATCH_TOLERANCE, or
+// that bound scaled by the gradient for the normals.
+
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "simd.h"
+#include "wave_batch.h"
+#include "wave_strip.h"
+#include "wave_table.h"
+
+
+// fmaxf() drops NaN, which here marks a vertex that was never written
+static float worse(float err, float e)
+{
+    return e == e ? fmaxf(err, e) : INFINITY;
+}
+
+
+static float height_error(const SeaGrid &g, const WaveParams &w, float timer, const std::vector<float> &heights)
+{
+    float err = 0;
+    for (int xi = -g.xfield; xi <= g.xfield + 1; xi++)
+        for (int zi = -g.zfield; zi <= g.zfield + 1; zi++)
+            err = worse(err, fabsf(heights[sea_index(g, xi, zi)] - wave_height(w, xi, zi, timer)));
+    return err;
+}
+
+
+// normals of sea_heights_normals() against the gradient at every vertex, relative to its size
+static float normal_error(const SeaGrid &g, const WaveParams &w, float timer, const std::vector<float> &normals)
+{
+    float err = 0, q = g.quadsize;
+    for (int xi = -g.xfield; xi <= g.xfield + 1; xi++)
+        for (int zi = -g.zfield; zi <= g.zfield + 1; zi++)
+        {
+            float gx, gz;
+            wave_height_grad(w, xi, zi, timer, &gx, &gz);
+            const float *n = &normals[3 * sea_index(g, xi, zi)];
+            float scale = fmaxf(1, fmaxf(fabsf(gx), fabsf(gz)));
+            err = worse(err, fabsf(n[0] - q * gx) / (q * scale));
+            err = worse(err, fabsf(n[1] + q * q));
+            err = worse(err, fabsf(n[2] - q * gz) / (q * scale));
+        }
+    return err;
+}
+
+
+int main()
+{
+    const int fields[] = {1, 2, 3, 51};
+    const float timers[] = {0, 5000};               // timer * speed = 0 and 40
+    JobSystem jobs(3);
+    int failures = 0;
+    for (int p = SIMD_SCALAR; p <= SIMD_AVX2; p++)
+    {
+        simd_force((SimdPath)p);
+        if (simd_path() != p)
+        {
+            printf("%-6s not supported, skipped\n", simd_name((SimdPath)p));
+            continue;
+        }
+        for (int field : fields)
+        {
+            SeaGrid g;
+            g.xfield = g.zfield = field;
+            WaveParams w;
+            WaveTable table;
+            wave_table_build(table, g, w, &jobs);
+            size_t n = sea_vertices(g);
+            std::vector<float> heights(n), normals(3 * n);
+            float worst[4] = {0, 0, 0, 0};
+            for (float timer : timers)
+            {
+                heights.assign(n, NAN);
+                sea_heights(g, w, timer, heights.data(), &jobs);
+                worst[0] = fmaxf(worst[0], height_error(g, w, timer, heights));
+
+                heights.assign(n, NAN);
+                normals.assign(3 * n, NAN);
+                sea_heights_normals(g, w, timer, heights.data(), normals.data(), &jobs);
+                worst[1] = fmaxf(worst[1], fmaxf(height_error(g, w, timer, heights),
+                                                 normal_error(g, w, timer, normals)));
+
+                heights.assign(n, NAN);
+                sea_heights_strip(g, w, timer, heights.data(), &jobs);
+                worst[2] = fmaxf(worst[2], height_error(g, w, timer, heights));
+
+                heights.assign(n, NAN);
+                wave_table_heights(table, w, timer, heights.data(), &jobs);
+                worst[3] = fmaxf(worst[3], height_error(g, w, timer, heights));
+            }
+            const char *names[4] = {"heights", "normals", "strip", "table"};
+            for (int s = 0; s < 4; s++)
+            {
+                bool ok = worst[s] <= WAVE_BATCH_TOLERANCE;
+                printf("%-6s field %2d %-8s: max error %g%s\n", simd_name((SimdPath)p), field, names[s], worst[s],
+                       ok ? "" : "  FAILED");
+                failures += !ok;
+            }
+        }
+    }
+    simd_force(simd_detect());
+    return failures ? 1 : 0;
+}
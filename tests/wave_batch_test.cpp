@@ -0,0 +1,79 @@
+// Checks the batch wave evaluator against scalar wave_height() on every simd
+// path the cpu supports, for 1 to 8 octaves, on a small and a large grid at
+// small and large timers, and with 8 octaves on the outer columns of the
+// largest field, where the phases reach 6e9 radians. Fails when an error
+// exceeds WAVE_BATCH_TOLERANCE.
+
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "simd.h"
+#include "wave_batch.h"
+#include "sea.h"
+
+
+// largest error over the two outermost columns of each side of a field, which hold
+// the largest |x*z| of the grid; the whole SEA_MAX_FIELD grid would take minutes
+static float edge_error(const WaveParams &w, int field, float timer)
+{
+    int depth = 2 * field + 2;
+    std::vector<float> x(depth), z(depth), heights(depth);
+    const int columns[] = {-field, -field + 1, field, field + 1};
+    float err = 0;
+    for (int xi : columns)
+    {
+        for (int k = 0; k < depth; k++)
+        {
+            x[k] = xi;
+            z[k] = k - field;
+        }
+        wave_height_batch(w, x.data(), z.data(), depth, timer, heights.data());
+        for (int k = 0; k < depth; k++)
+            err = fmaxf(err, fabsf(heights[k] - wave_height(w, x[k], z[k], timer)));
+    }
+    return err;
+}
+
+
+int main()
+{
+    const int fields[] = {50, 200};
+    const float timers[] = {0, 5000, 1e6f};
+    int failures = 0;
+    for (int p = SIMD_SCALAR; p <= SIMD_AVX2; p++)
+    {
+        simd_force((SimdPath)p);
+        if (simd_path() != p)
+        {
+            printf("%-6s not supported, skipped\n", simd_name((SimdPath)p));
+            continue;
+        }
+        for (int octaves = 1; octaves <= 8; octaves++)
+        {
+            WaveParams w;
+            w.octaves = octaves;
+            float worst = 0;
+            for (int field : fields)
+                for (float timer : timers)
+                {
+                    float err = wave_height_batch_error(w, field, field, timer);
+                    worst = err > worst ? err : worst;
+                }
+            bool ok = worst <= WAVE_BATCH_TOLERANCE;
+            printf("%-6s %d octaves: max error %g%s\n", simd_name((SimdPath)p), octaves, worst, ok ? "" : "  FAILED");
+            failures += !ok;
+        }
+
+        WaveParams w;
+        w.octaves = 8;
+        float worst = 0;
+        for (float timer : timers)
+            worst = fmaxf(worst, edge_error(w, SEA_MAX_FIELD, timer));
+        bool ok = worst <= WAVE_BATCH_TOLERANCE;
+        printf("%-6s 8 octaves, field %d edges: max error %g%s\n", simd_name((SimdPath)p), SEA_MAX_FIELD, worst,
+               ok ? "" : "  FAILED");
+        failures += !ok;
+    }
+    simd_force(simd_detect());
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,30 @@
+// Checks the strip heights against the wave model evaluated directly in double
+// precision on a 50x50 and a 500x500 field, at timers up to 1e6 ms where the
+// time phase alone is 8000 radians. Fails when an error exceeds
+// WAVE_STRIP_TOLERANCE.
+
+#include <stdio.h>
+#include <math.h>
+#include "wave_strip.h"
+
+
+int main()
+{
+    const int fields[] = {50, 500};
+    const float timers[] = {0, 5000, 1e6f};
+    const int octaves[] = {1, 5, 8};
+    int failures = 0;
+    for (int field : fields)
+        for (int o : octaves)
+        {
+            WaveParams w;
+            w.octaves = o;
+            double worst = 0;
+            for (float timer : timers)
+                worst = fmax(worst, wave_height_strip_error(w, field, field, timer));
+            bool ok = worst <= WAVE_STRIP_TOLERANCE;
+            printf("field %3d %d octaves: max error %g%s\n", field, o, worst, ok ? "" : "  FAILED");
+            failures += !ok;
+        }
+    return failures ? 1 : 0;
+}
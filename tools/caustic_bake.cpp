@@ -0,0 +1,92 @@
+// Bakes one loop of the trig waves' photon caustics into an atlas file that the
+// viewer replays with --caustic-atlas (see src/sim/caustic_atlas.h).
+//   caustic_bake [--frames N] [--photons N] [--size N] [--threads N] [--grid settings] [--output file]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "caustic_atlas.h"
+
+
+static void usage(const char *name)
+{
+    printf("usage: %s [--frames N] [--photons N] [--size N] [--threads N] [--grid field=50,...]"
+           " [--output caustics.ocat]\n", name);
+}
+
+
+int main(int argc, char **argv)
+{
+    // the viewer's sea and wave defaults, so the atlas lines up with its grid; the
+    // viewer refuses an atlas baked for other settings than its own
+    SeaGrid grid;
+    WaveParams wave;
+    CausticParams params;
+    int frames = 64;
+    int threads = 0;
+    const char *output = "caustics.ocat";
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0)
+        {
+            usage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        const char *value = argv[++i];
+        if (strcmp(arg, "--frames") == 0)
+            frames = atoi(value);
+        else if (strcmp(arg, "--photons") == 0)
+            params.photons = atoi(value);
+        else if (strcmp(arg, "--size") == 0)
+            params.size = atoi(value);
+        else if (strcmp(arg, "--threads") == 0)
+            threads = atoi(value);
+        else if (strcmp(arg, "--grid") == 0)
+        {
+            if (!sea_grid_parse(grid, value))
+            {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (strcmp(arg, "--output") == 0)
+            output = value;
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (frames < 1 || params.photons < 1 || params.size < 1 || !sea_grid_valid(grid))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    JobSystem jobs(threads);
+    CausticAtlasHeader h;
+    h.size = params.size;
+    h.frames = frames;
+    h.period = wave_period(wave);
+    h.grid = grid;
+    h.wave = wave;
+    std::vector<unsigned char> bytes;
+    auto start = std::chrono::steady_clock::now();
+    caustic_atlas_bake(grid, wave, params, frames, bytes, &jobs);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (!caustic_atlas_write(output, h, bytes.data()))
+    {
+        fprintf(stderr, "cannot write %s\n", output);
+        return 1;
+    }
+    printf("%s: %d frames of %dx%d over %.1f ms of waves, %d photons per side, baked in %.0f ms (%.1f ms per frame)\n",
+           output, frames, h.size, h.size, h.period, params.photons, ms, ms / frames);
+    return 0;
+}